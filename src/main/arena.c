@@ -0,0 +1,140 @@
+// Bump allocator for per-frame scratch buffers
+// Created by James Schaffer on 16/10/2026.
+
+#include "arena.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ARENA_ROUND(x) (((x) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct ArenaBlock {
+	ArenaBlock* next;
+	size_t size, used;
+	char pad[ARENA_ALIGN - sizeof(ArenaBlock*) - 2 * sizeof(size_t)];
+	Uint8 data[];
+};
+
+static void* alignedAllocOrDie(Arena* arena, const size_t bytes) {
+	void* ptr = SDL_aligned_alloc(ARENA_ALIGN, bytes);
+	if (!ptr) {
+		printf("Error allocating %zu bytes for arena '%s'\n", bytes, arena->name);
+		raise(SIGTERM);
+	}
+
+	arena->heapCalls++;
+	return ptr;
+}
+
+static void alignedFree(Arena* arena, void* ptr) {
+	if (!ptr) return;
+
+	SDL_aligned_free(ptr);
+	arena->heapCalls++;
+}
+
+void initArena(Arena* arena, const char* name, const size_t capacity) {
+	*arena = (Arena){0};
+	arena->name = name;
+	arena->capacity = ARENA_ROUND(capacity);
+	arena->base = alignedAllocOrDie(arena, arena->capacity);
+}
+
+static void freeOverflow(Arena* arena) {
+	while (arena->overflow) {
+		ArenaBlock* next = arena->overflow->next;
+		alignedFree(arena, arena->overflow);
+		arena->overflow = next;
+	}
+
+	arena->overflowUsed = 0;
+}
+
+void freeArena(Arena* arena) {
+	freeOverflow(arena);
+	alignedFree(arena, arena->base);
+
+	*arena = (Arena){0};
+}
+
+// ========== ALLOCATION ==========
+
+void* arenaAlloc(Arena* arena, size_t bytes) {
+	bytes = ARENA_ROUND(bytes ? bytes : 1);
+
+	void* ptr;
+
+	if (arena->used + bytes <= arena->capacity) {
+		ptr = arena->base + arena->used;
+		arena->used += bytes;
+	} else {
+		// Spill onto the heap, blocks at least as big as base so a bad cycle only takes a few of them
+		ArenaBlock* block = arena->overflow;
+
+		if (!block || block->used + bytes > block->size) {
+			const size_t size = bytes > arena->capacity ? bytes : arena->capacity;
+
+			block = alignedAllocOrDie(arena, sizeof(ArenaBlock) + size);
+			block->next = arena->overflow;
+			block->size = size;
+			block->used = 0;
+			arena->overflow = block;
+		}
+
+		ptr = block->data + block->used;
+		block->used += bytes;
+		arena->overflowUsed += bytes;
+	}
+
+	const size_t inUse = arena->used + arena->overflowUsed;
+	if (inUse > arena->cycleHighWater) arena->cycleHighWater = inUse;
+
+	return ptr;
+}
+
+void* arenaGrow(Arena* arena, void* ptr, const size_t oldBytes, const size_t newBytes) {
+	if (newBytes <= oldBytes) return ptr;
+
+	// Top of base : just move the bump pointer
+	const size_t oldSize = ARENA_ROUND(oldBytes);
+	if (ptr && (Uint8*)ptr + oldSize == arena->base + arena->used) {
+		const size_t extra = ARENA_ROUND(newBytes) - oldSize;
+
+		if (arena->used + extra <= arena->capacity) {
+			arena->used += extra;
+			if (arena->used + arena->overflowUsed > arena->cycleHighWater) {
+				arena->cycleHighWater = arena->used + arena->overflowUsed;
+			}
+			return ptr;
+		}
+	}
+
+	void* newPtr = arenaAlloc(arena, newBytes);
+	if (ptr && oldBytes) memcpy(newPtr, ptr, oldBytes);
+
+	return newPtr;
+}
+
+// ========== RESET ==========
+
+void arenaReset(Arena* arena) {
+	if (arena->cycleHighWater > arena->highWater) {
+		arena->highWater = arena->cycleHighWater;
+	}
+
+	// Spilled, one bigger base block replaces base + overflow (power of two so creeping growth doesn't realloc every cycle)
+	if (arena->overflow) {
+		freeOverflow(arena);
+
+		size_t capacity = arena->capacity ? arena->capacity : ARENA_ALIGN;
+		while (capacity < arena->cycleHighWater) capacity *= 2;
+
+		alignedFree(arena, arena->base);
+		arena->base = alignedAllocOrDie(arena, capacity);
+		arena->capacity = capacity;
+	}
+
+	arena->used = 0;
+	arena->cycleHighWater = 0;
+}
@@ -0,0 +1,55 @@
+// Bump allocator for per-frame scratch buffers
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_ARENA_H
+#define CUBERENDER_ARENA_H
+
+#include <SDL3/SDL_stdinc.h>
+
+// Every allocation is aligned for the 8 wide float kernels (same as MESH_SOA_ALIGN)
+#define ARENA_ALIGN			32
+
+// Debug builds check that steady-state frames are served without touching the heap
+#ifndef ARENA_DEBUG
+	#ifdef NDEBUG
+		#define ARENA_DEBUG 0
+	#else
+		#define ARENA_DEBUG 1
+	#endif
+#endif
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Not thread safe, each thread that needs scratch memory owns its own arena
+typedef struct {
+	const char* name;
+
+	Uint8* base;
+	size_t capacity;
+	size_t used;
+
+	// Heap blocks for whatever didn't fit in base this cycle, freed (and base grown) on reset
+	ArenaBlock* overflow;
+	size_t overflowUsed;
+
+	size_t cycleHighWater;	// most bytes in use since the last reset
+	size_t highWater;		// most bytes in use in any cycle
+
+	Uint64 heapCalls;		// mallocs / frees made by the arena since it was created
+} Arena;
+
+void initArena(Arena* arena, const char* name, size_t capacity);
+void freeArena(Arena* arena);
+
+// Never fails (raises SIGTERM like the other allocators), memory is uninitialised
+void* arenaAlloc(Arena* arena, size_t bytes);
+#define ARENA_ARRAY(arena, type, count) ((type*)arenaAlloc((arena), (size_t)(count) * sizeof(type)))
+
+// New allocation of newBytes with the first oldBytes of ptr copied over, in place when ptr was the last allocation
+void* arenaGrow(Arena* arena, void* ptr, size_t oldBytes, size_t newBytes);
+
+// Frees everything at once. If the cycle spilled onto the heap, base is regrown to fit the high water mark
+// so the same workload next cycle stays inside it
+void arenaReset(Arena* arena);
+
+#endif //CUBERENDER_ARENA_H
@@ -0,0 +1,123 @@
+// Batched triangle submission
+// Created by James Schaffer on 16/10/2026.
+
+#include "batch.h"
+#include "profiler.h"
+
+#include <string.h>
+
+// Invalidates every slot in O(1) by moving the stamp on
+static void nextStamp(RenderBatch* batch) {
+	batch->stamp++;
+
+	// Wrapped around, old stamps could match again so clear them
+	if (batch->stamp == 0) {
+		memset(batch->slotStamp, 0, batch->slotCapacity * sizeof(unsigned int));
+		batch->stamp = 1;
+	}
+}
+
+// Start of a frame, the vertex and index buffers come from the arena and stay valid until it's reset.
+// They start at last frame's size so a steady scene never has to grow them
+void batchBegin(RenderBatch* batch, Arena* arena) {
+	if (batch->vertexCapacity < BATCH_INITIAL_CAPACITY) batch->vertexCapacity = BATCH_INITIAL_CAPACITY;
+	if (batch->indexCapacity < BATCH_INITIAL_CAPACITY * 3) batch->indexCapacity = BATCH_INITIAL_CAPACITY * 3;
+
+	batch->arena = arena;
+	batch->vertices = ARENA_ARRAY(arena, SDL_Vertex, batch->vertexCapacity);
+	batch->indices = ARENA_ARRAY(arena, int, batch->indexCapacity);
+
+	batch->vertexCount = 0;
+	batch->indexCount = 0;
+	batch->drawCalls = 0;
+	batch->texture = NULL;
+	batch->blendMode = SDL_BLENDMODE_NONE;
+}
+
+// Start of each mesh or instance : fresh vertex slots (valid until slotArena is reset), triangles keep
+// going into the open batch so consecutive meshes share a draw call
+void batchBeginMesh(RenderBatch* batch, Arena* slotArena, const size_t meshVertexCount) {
+	batch->slots = ARENA_ARRAY(slotArena, int, meshVertexCount);
+	batch->slotStamp = ARENA_ARRAY(slotArena, unsigned int, meshVertexCount);
+	batch->slotCapacity = meshVertexCount;
+
+	// Fresh memory, so no stamp can match until the first vertex is added
+	memset(batch->slotStamp, 0, meshVertexCount * sizeof(unsigned int));
+	batch->stamp = 1;
+}
+
+static void growBatch(RenderBatch* batch) {
+	int vertexCapacity = batch->vertexCapacity * 2;
+	int indexCapacity = batch->indexCapacity * 2;
+
+	if (vertexCapacity > BATCH_MAX_VERTICES) vertexCapacity = BATCH_MAX_VERTICES;
+	if (indexCapacity > BATCH_MAX_INDICES) indexCapacity = BATCH_MAX_INDICES;
+
+	batch->vertices = arenaGrow(batch->arena, batch->vertices, batch->vertexCount * sizeof(SDL_Vertex), vertexCapacity * sizeof(SDL_Vertex));
+	batch->indices = arenaGrow(batch->arena, batch->indices, batch->indexCount * sizeof(int), indexCapacity * sizeof(int));
+	batch->vertexCapacity = vertexCapacity;
+	batch->indexCapacity = indexCapacity;
+}
+
+// Adds a triangle drawn with texture (NULL = untextured) and blendMode. ids are mesh vertex indices (-1 = never shared), a vertex
+// is re-used when its colour and texture coordinate match too (a position on a hard edge or UV seam has several)
+void batchAddTri(RenderBatch* batch, SDL_Renderer* renderer, SDL_Texture* texture, const SDL_BlendMode blendMode, const int ids[3], const SDL_Vertex verts[3]) {
+	// One texture and blend mode per draw call
+	if (texture != batch->texture || blendMode != batch->blendMode) {
+		batchFlush(batch, renderer);
+		batch->texture = texture;
+		batch->blendMode = blendMode;
+	}
+
+	// Worst case all 3 vertices are new
+	if (batch->vertexCount + 3 > batch->vertexCapacity || batch->indexCount + 3 > batch->indexCapacity) {
+		if (batch->vertexCapacity < BATCH_MAX_VERTICES && batch->indexCapacity < BATCH_MAX_INDICES) {
+			growBatch(batch);
+		} else {
+			batchFlush(batch, renderer);
+		}
+	}
+
+	for (int i=0; i<3; ++i) {
+		const int id = ids[i];
+
+		if (id >= 0 && batch->slotStamp[id] == batch->stamp && memcmp(&batch->vertices[batch->slots[id]], &verts[i], sizeof(SDL_Vertex)) == 0) {
+			batch->indices[batch->indexCount++] = batch->slots[id];
+			continue;
+		}
+
+		const int slot = batch->vertexCount++;
+		batch->vertices[slot] = verts[i];
+		batch->indices[batch->indexCount++] = slot;
+
+		if (id >= 0) {
+			batch->slots[id] = slot;
+			batch->slotStamp[id] = batch->stamp;
+		}
+	}
+}
+
+// Submits everything in the batch as one indexed draw call
+void batchFlush(RenderBatch* batch, SDL_Renderer* renderer) {
+	if (batch->indexCount > 0) {
+		PROFILE_BEGIN(PROFILE_STAGE_GEOMETRY);
+
+		// Textured geometry blends with the texture's mode, untextured with the renderer's draw mode
+		if (batch->texture) {
+			SDL_SetTextureBlendMode(batch->texture, batch->blendMode);
+		} else {
+			SDL_SetRenderDrawBlendMode(renderer, batch->blendMode);
+		}
+
+		SDL_RenderGeometry(renderer, batch->texture, batch->vertices, batch->vertexCount, batch->indices, batch->indexCount);
+		PROFILE_END(PROFILE_STAGE_GEOMETRY);
+		PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS, 1);
+		batch->drawCalls++;
+	}
+
+	batch->vertexCount = 0;
+	batch->indexCount = 0;
+
+	// Slots point into the chunk that was just submitted
+	nextStamp(batch);
+}
@@ -0,0 +1,43 @@
+// Batched triangle submission
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_BATCH_H
+#define CUBERENDER_BATCH_H
+
+#include <SDL3/SDL_render.h>
+
+#include "arena.h"
+
+// Size cap for a single SDL_RenderGeometry call, the batch is split into chunks past this
+#define BATCH_MAX_VERTICES	65536
+#define BATCH_MAX_INDICES	(BATCH_MAX_VERTICES * 3)
+
+#define BATCH_INITIAL_CAPACITY	1024
+
+// One batch is open for the whole frame and only flushed when full, when the texture or blend mode changes or at the end,
+// so every mesh and instance drawn in a frame can end up in a single SDL_RenderGeometry call
+typedef struct {
+	Arena* arena;
+	SDL_Texture* texture;
+	SDL_BlendMode blendMode;
+	SDL_Vertex* vertices;
+	int* indices;
+
+	int vertexCount, indexCount;
+	int vertexCapacity, indexCapacity;
+
+	// Mesh vertex index -> batch vertex, only valid while slotStamp[i] == stamp
+	int* slots;
+	unsigned int* slotStamp;
+	size_t slotCapacity;
+	unsigned int stamp;
+
+	int drawCalls;
+} RenderBatch;
+
+void batchBegin(RenderBatch* batch, Arena* arena);
+void batchBeginMesh(RenderBatch* batch, Arena* slotArena, size_t meshVertexCount);
+void batchAddTri(RenderBatch* batch, SDL_Renderer* renderer, SDL_Texture* texture, SDL_BlendMode blendMode, const int ids[3], const SDL_Vertex verts[3]);
+void batchFlush(RenderBatch* batch, SDL_Renderer* renderer);
+
+#endif //CUBERENDER_BATCH_H
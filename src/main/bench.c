@@ -0,0 +1,275 @@
+// Headless benchmark mode (--bench) and its timing report
+// Created by James Schaffer on 16/10/2026.
+
+#include "bench.h"
+#include "capture.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ========== ARGUMENTS ==========
+
+static void printBenchUsage(const char* exe) {
+	printf("Usage : %s [--instances N] [--fps N]\n", exe);
+	printf("        %s --bench [mesh.obj] [--frames N] [--out report.json|report.csv] [--raster] [--unsorted] [--no-occlusion] [--instances N]\n", exe);
+	printf("        %s --bench [mesh.obj] --capture DIR | --compare DIR [--tolerance N] [--max-mismatch PERCENT] [--raster]\n", exe);
+	printf("        %s --occlusion-check [mesh.obj]\n", exe);
+}
+
+// Returns false on bad arguments. Without --bench the window opens as normal, only --instances and --fps are used
+bool parseBenchArgs(const int argc, char** argv, BenchOptions* options) {
+	*options = (BenchOptions){
+		.enabled = false,
+		.softwareRaster = false,
+		.unsorted = false,
+		.noOcclusion = false,
+		.occlusionCheck = false,
+		.meshFile = BENCH_DEFAULT_MESH,
+		.outputPath = BENCH_DEFAULT_OUTPUT,
+		.frames = BENCH_DEFAULT_FRAMES,
+		.instances = 0,
+		.targetFps = 0,
+		.captureDir = NULL,
+		.compareDir = NULL,
+		.tolerance = CAPTURE_DEFAULT_TOLERANCE,
+		.maxMismatch = 0
+	};
+
+	bool meshGiven = false;
+
+	for (int i=1; i<argc; ++i) {
+		const char* arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(arg, "--bench") == 0) {
+			options->enabled = true;
+
+			// Optional mesh name straight after
+			if (hasValue && strncmp(argv[i+1], "--", 2) != 0) {
+				options->meshFile = argv[++i];
+				meshGiven = true;
+			}
+		} else if (strcmp(arg, "--occlusion-check") == 0) {
+			options->occlusionCheck = true;
+
+			if (hasValue && strncmp(argv[i+1], "--", 2) != 0) {
+				options->meshFile = argv[++i];
+				meshGiven = true;
+			}
+		} else if (strcmp(arg, "--frames") == 0 && hasValue) {
+			options->frames = atoi(argv[++i]);
+
+			if (options->frames <= 0) {
+				printf("Bad frame count '%s'\n", argv[i]);
+				return false;
+			}
+		} else if (strcmp(arg, "--out") == 0 && hasValue) {
+			options->outputPath = argv[++i];
+		} else if (strcmp(arg, "--instances") == 0 && hasValue) {
+			options->instances = atoi(argv[++i]);
+
+			if (options->instances < 0) {
+				printf("Bad instance count '%s'\n", argv[i]);
+				return false;
+			}
+		} else if (strcmp(arg, "--fps") == 0 && hasValue) {
+			options->targetFps = atoi(argv[++i]);
+
+			if (options->targetFps < 0) {
+				printf("Bad fps cap '%s'\n", argv[i]);
+				return false;
+			}
+		} else if (strcmp(arg, "--capture") == 0 && hasValue) {
+			options->captureDir = argv[++i];
+		} else if (strcmp(arg, "--compare") == 0 && hasValue) {
+			options->compareDir = argv[++i];
+		} else if (strcmp(arg, "--tolerance") == 0 && hasValue) {
+			options->tolerance = atoi(argv[++i]);
+
+			if (options->tolerance < 0 || options->tolerance > 255) {
+				printf("Bad tolerance '%s', expected 0-255\n", argv[i]);
+				return false;
+			}
+		} else if (strcmp(arg, "--max-mismatch") == 0 && hasValue) {
+			options->maxMismatch = atof(argv[++i]);
+
+			if (options->maxMismatch < 0 || options->maxMismatch > 100) {
+				printf("Bad mismatch percentage '%s'\n", argv[i]);
+				return false;
+			}
+		} else if (strcmp(arg, "--raster") == 0) {
+			options->softwareRaster = true;
+		} else if (strcmp(arg, "--unsorted") == 0) {
+			options->unsorted = true;
+		} else if (strcmp(arg, "--no-occlusion") == 0) {
+			options->noOcclusion = true;
+		} else {
+			printf("Unknown argument '%s'\n", arg);
+			printBenchUsage(argv[0]);
+			return false;
+		}
+	}
+
+	if (options->captureDir && options->compareDir) {
+		puts("--capture and --compare can't be used together");
+		return false;
+	}
+
+	// Capturing is always headless
+	if (options->captureDir || options->compareDir) {
+		options->enabled = true;
+	}
+
+	// So is the occlusion check, on a tessellated mesh unless another one was given
+	if (options->occlusionCheck) {
+		options->enabled = true;
+		if (!meshGiven) options->meshFile = BENCH_OCCLUSION_CHECK_MESH;
+	}
+
+	return true;
+}
+
+// ========== TIMINGS ==========
+
+void benchRecordFrame(BenchTimings* timings, const double ms) {
+	if (timings->count == timings->capacity) {
+		const int capacity = timings->capacity ? timings->capacity * 2 : 1024;
+
+		double* newFrames = realloc(timings->frameMs, capacity * sizeof(double));
+		if (!newFrames) {
+			puts("Error resizing bench timings");
+			raise(SIGTERM);
+		}
+
+		timings->frameMs = newFrames;
+		timings->capacity = capacity;
+	}
+
+	timings->frameMs[timings->count++] = ms;
+}
+
+void freeBenchTimings(BenchTimings* timings) {
+	free(timings->frameMs);
+	*timings = (BenchTimings){0};
+}
+
+static int compareDoubles(const void* a, const void* b) {
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// Nearest rank percentile of sorted values
+static double percentile(const double* sorted, const int count, const double p) {
+	int rank = (int)ceil(p / 100.0 * count);
+	if (rank < 1) rank = 1;
+	if (rank > count) rank = count;
+
+	return sorted[rank - 1];
+}
+
+BenchSummary summarizeBench(const BenchTimings* timings) {
+	BenchSummary summary = {0};
+	if (timings->count == 0) return summary;
+
+	double* sorted = malloc(timings->count * sizeof(double));
+	if (!sorted) {
+		puts("Error allocating bench summary");
+		raise(SIGTERM);
+	}
+
+	memcpy(sorted, timings->frameMs, timings->count * sizeof(double));
+	qsort(sorted, timings->count, sizeof(double), compareDoubles);
+
+	double total = 0;
+	for (int i=0; i<timings->count; ++i) total += sorted[i];
+
+	summary.min = sorted[0];
+	summary.max = sorted[timings->count - 1];
+	summary.mean = total / timings->count;
+	summary.p50 = percentile(sorted, timings->count, 50);
+	summary.p95 = percentile(sorted, timings->count, 95);
+	summary.p99 = percentile(sorted, timings->count, 99);
+
+	free(sorted);
+	return summary;
+}
+
+// ========== REPORT ==========
+
+static bool endsWith(const char* str, const char* suffix) {
+	const size_t len = strlen(str), suffixLen = strlen(suffix);
+	return len >= suffixLen && SDL_strcasecmp(str + len - suffixLen, suffix) == 0;
+}
+
+// Mesh names come from the command line, so quotes and backslashes are escaped
+static void writeJSONString(FILE* fptr, const char* str) {
+	fputc('"', fptr);
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\') fputc('\\', fptr);
+		if ((unsigned char)*str >= 0x20) fputc(*str, fptr);
+	}
+	fputc('"', fptr);
+}
+
+static void writeJSON(FILE* fptr, const BenchOptions* options, const BenchTimings* timings, const BenchSummary* s, const char* rendererName) {
+	fprintf(fptr, "{\n");
+	fprintf(fptr, "\t\"mesh\": ");
+	writeJSONString(fptr, options->meshFile);
+	fprintf(fptr, ",\n\t\"renderer\": ");
+	writeJSONString(fptr, rendererName);
+	fprintf(fptr, ",\n\t\"backend\": \"%s\",\n", options->softwareRaster ? "raster" : "geometry");
+	fprintf(fptr, "\t\"painter_sort\": %s,\n", options->unsorted ? "false" : "true");
+	fprintf(fptr, "\t\"occlusion_culling\": %s,\n", options->noOcclusion ? "false" : "true");
+	fprintf(fptr, "\t\"frames\": %i,\n", timings->count);
+	fprintf(fptr, "\t\"warmup_frames\": %i,\n", BENCH_WARMUP_FRAMES);
+	fprintf(fptr, "\t\"summary_ms\": { \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+		s->min, s->mean, s->p50, s->p95, s->p99, s->max);
+
+	fprintf(fptr, "\t\"frame_ms\": [");
+	for (int i=0; i<timings->count; ++i) {
+		fprintf(fptr, "%s%s%.4f", i ? "," : "", i % 16 ? " " : "\n\t\t", timings->frameMs[i]);
+	}
+	fprintf(fptr, "\n\t]\n}\n");
+}
+
+// One row per frame, the summary goes in '#' comment lines so CSV readers can skip it
+static void writeCSV(FILE* fptr, const BenchOptions* options, const BenchTimings* timings, const BenchSummary* s, const char* rendererName) {
+	fprintf(fptr, "# mesh=%s renderer=%s backend=%s painter_sort=%s occlusion_culling=%s frames=%i\n",
+		options->meshFile, rendererName, options->softwareRaster ? "raster" : "geometry", options->unsorted ? "off" : "on",
+		options->noOcclusion ? "off" : "on", timings->count);
+	fprintf(fptr, "# min=%.4f mean=%.4f p50=%.4f p95=%.4f p99=%.4f max=%.4f\n",
+		s->min, s->mean, s->p50, s->p95, s->p99, s->max);
+
+	fprintf(fptr, "frame,ms\n");
+	for (int i=0; i<timings->count; ++i) {
+		fprintf(fptr, "%i,%.4f\n", i, timings->frameMs[i]);
+	}
+}
+
+bool writeBenchReport(const BenchOptions* options, const BenchTimings* timings, const char* rendererName) {
+	const BenchSummary summary = summarizeBench(timings);
+
+	printf("Bench '%s' : %i frames, min %.3fms mean %.3fms p50 %.3fms p95 %.3fms p99 %.3fms\n",
+		options->meshFile, timings->count, summary.min, summary.mean, summary.p50, summary.p95, summary.p99);
+
+	FILE* fptr = fopen(options->outputPath, "w");
+	if (fptr == NULL) {
+		printf("Error opening bench report '%s'\n", options->outputPath);
+		return false;
+	}
+
+	if (endsWith(options->outputPath, ".csv")) {
+		writeCSV(fptr, options, timings, &summary, rendererName);
+	} else {
+		writeJSON(fptr, options, timings, &summary, rendererName);
+	}
+
+	const bool ok = ferror(fptr) == 0;
+	fclose(fptr);
+
+	if (ok) printf("Wrote bench report to '%s'\n", options->outputPath);
+	return ok;
+}
@@ -0,0 +1,62 @@
+// Headless benchmark mode (--bench) and its timing report
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_BENCH_H
+#define CUBERENDER_BENCH_H
+
+#include <SDL3/SDL_stdinc.h>
+
+#define BENCH_DEFAULT_MESH		"cat.obj"
+
+// Tessellated occluder --occlusion-check uses when no mesh is given
+#define BENCH_OCCLUSION_CHECK_MESH	"Sphere.obj"
+#define BENCH_DEFAULT_FRAMES	600
+#define BENCH_DEFAULT_OUTPUT	"bench.json"
+
+// Frames rendered before timing starts (first touches of buffers, textures, caches)
+#define BENCH_WARMUP_FRAMES		10
+
+// Simulated time step, so the scripted path is the same however fast the machine is
+#define BENCH_FRAME_DELTA		(1.0 / 60.0)
+
+typedef struct {
+	bool enabled;
+	bool softwareRaster; // --raster : tiled rasterizer instead of SDL_RenderGeometry
+	bool unsorted; // --unsorted : painter's sort off, geometry drawn in material / texture state order
+	bool noOcclusion; // --no-occlusion : every object is drawn even when hidden behind another
+	bool occlusionCheck; // --occlusion-check : the mesh, scaled up, must hide a box behind it (exit code 1 if not)
+
+	const char* meshFile;
+	const char* outputPath; // .csv writes CSV, anything else JSON
+	int frames;
+
+	// Also used without --bench : --instances N adds N copies of the first mesh in a grid,
+	// --fps N caps the interactive window's frame rate (0 = uncapped)
+	int instances;
+	int targetFps;
+
+	// --capture DIR writes reference images of fixed views instead of timing, --compare DIR checks against them
+	const char* captureDir;
+	const char* compareDir;
+	int tolerance;		// per channel, 0-255
+	double maxMismatch;	// percent of pixels allowed outside the tolerance
+} BenchOptions;
+
+typedef struct {
+	double* frameMs;
+	int count, capacity;
+} BenchTimings;
+
+typedef struct {
+	double min, mean, p50, p95, p99, max;
+} BenchSummary;
+
+bool parseBenchArgs(int argc, char** argv, BenchOptions* options);
+
+void benchRecordFrame(BenchTimings* timings, double ms);
+void freeBenchTimings(BenchTimings* timings);
+
+BenchSummary summarizeBench(const BenchTimings* timings);
+bool writeBenchReport(const BenchOptions* options, const BenchTimings* timings, const char* rendererName);
+
+#endif //CUBERENDER_BENCH_H
@@ -0,0 +1,179 @@
+// Frame capture to PPM files and comparison against reference images
+// Created by James Schaffer on 16/10/2026.
+
+#include "capture.h"
+#include "objparse.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ========== PPM ==========
+
+// Binary (P6) 8 bit RGB, rows written top to bottom without the surface pitch padding
+bool writePPM(const char* path, SDL_Surface* surface) {
+	SDL_Surface* rgb = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGB24);
+	if (!rgb) {
+		printf("Error converting capture for '%s' : %s\n", path, SDL_GetError());
+		return false;
+	}
+
+	FILE* fptr = fopen(path, "wb");
+	if (fptr == NULL) {
+		printf("Error opening '%s' for writing\n", path);
+		SDL_DestroySurface(rgb);
+		return false;
+	}
+
+	fprintf(fptr, "P6\n%i %i\n255\n", rgb->w, rgb->h);
+
+	for (int y=0; y<rgb->h; ++y) {
+		fwrite((const Uint8*)rgb->pixels + (size_t)y * rgb->pitch, 3, rgb->w, fptr);
+	}
+
+	const bool ok = ferror(fptr) == 0;
+	fclose(fptr);
+	SDL_DestroySurface(rgb);
+
+	if (!ok) printf("Error writing '%s'\n", path);
+	return ok;
+}
+
+// Header fields are separated by whitespace, '#' comments run to the end of the line
+static const char* ppmNextInt(const char* p, const char* end, int* value) {
+	for (;;) {
+		while (p < end && isspace((unsigned char)*p)) p++;
+		if (p < end && *p == '#') {
+			while (p < end && *p != '\n') p++;
+			continue;
+		}
+		break;
+	}
+
+	if (p == end || !isdigit((unsigned char)*p)) return NULL;
+
+	int v = 0;
+	while (p < end && isdigit((unsigned char)*p)) {
+		v = v * 10 + (*p - '0');
+		if (v > 1 << 16) return NULL;
+		p++;
+	}
+
+	*value = v;
+	return p;
+}
+
+SDL_Surface* readPPM(const char* path) {
+	size_t length;
+	char* data = readWholeFile(path, &length);
+	if (!data) {
+		printf("Error opening '%s'\n", path);
+		return NULL;
+	}
+
+	const char* end = data + length;
+	const char* p = data;
+	int width = 0, height = 0, maxValue = 0;
+
+	if (length < 2 || p[0] != 'P' || p[1] != '6' ||
+		!(p = ppmNextInt(p + 2, end, &width)) ||
+		!(p = ppmNextInt(p, end, &height)) ||
+		!(p = ppmNextInt(p, end, &maxValue)) ||
+		width <= 0 || height <= 0 || maxValue != 255 || p == end) {
+		printf("'%s' is not an 8 bit binary PPM\n", path);
+		free(data);
+		return NULL;
+	}
+
+	// Exactly one whitespace character between the header and the pixels
+	p++;
+
+	const size_t rowBytes = (size_t)width * 3;
+	if ((size_t)(end - p) < rowBytes * height) {
+		printf("'%s' is truncated\n", path);
+		free(data);
+		return NULL;
+	}
+
+	SDL_Surface* surface = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGB24);
+	if (!surface) {
+		printf("Error creating surface for '%s' : %s\n", path, SDL_GetError());
+		free(data);
+		return NULL;
+	}
+
+	for (int y=0; y<height; ++y) {
+		memcpy((Uint8*)surface->pixels + (size_t)y * surface->pitch, p + rowBytes * y, rowBytes);
+	}
+
+	free(data);
+	return surface;
+}
+
+// ========== COMPARE ==========
+
+bool compareImages(SDL_Surface* reference, SDL_Surface* image, const int tolerance, ImageDiff* diff, SDL_Surface** diffOut) {
+	*diff = (ImageDiff){0};
+	if (diffOut) *diffOut = NULL;
+
+	if (reference->w != image->w || reference->h != image->h) {
+		printf("Image size %ix%i does not match the reference %ix%i\n", image->w, image->h, reference->w, reference->h);
+		return false;
+	}
+
+	SDL_Surface* a = SDL_ConvertSurface(reference, SDL_PIXELFORMAT_RGB24);
+	SDL_Surface* b = SDL_ConvertSurface(image, SDL_PIXELFORMAT_RGB24);
+	SDL_Surface* out = diffOut ? SDL_CreateSurface(reference->w, reference->h, SDL_PIXELFORMAT_RGB24) : NULL;
+
+	if (!a || !b || (diffOut && !out)) {
+		printf("Error converting images for comparison : %s\n", SDL_GetError());
+		SDL_DestroySurface(a);
+		SDL_DestroySurface(b);
+		SDL_DestroySurface(out);
+		return false;
+	}
+
+	diff->width = a->w;
+	diff->height = a->h;
+	diff->pixelCount = a->w * a->h;
+
+	Uint64 totalDelta = 0;
+
+	for (int y=0; y<a->h; ++y) {
+		const Uint8* rowA = (const Uint8*)a->pixels + (size_t)y * a->pitch;
+		const Uint8* rowB = (const Uint8*)b->pixels + (size_t)y * b->pitch;
+		Uint8* rowOut = out ? (Uint8*)out->pixels + (size_t)y * out->pitch : NULL;
+
+		for (int x=0; x<a->w; ++x) {
+			int delta = 0;
+			for (int c=0; c<3; ++c) {
+				const int d = abs(rowA[x*3 + c] - rowB[x*3 + c]);
+				totalDelta += d;
+				if (d > delta) delta = d;
+			}
+
+			if (delta > diff->maxDelta) diff->maxDelta = delta;
+			if (delta > tolerance) diff->mismatched++;
+
+			if (!rowOut) continue;
+
+			if (delta > tolerance) {
+				rowOut[x*3 + 0] = (Uint8)(128 + delta / 2);
+				rowOut[x*3 + 1] = 0;
+				rowOut[x*3 + 2] = 0;
+			} else {
+				const Uint8 grey = (Uint8)((rowA[x*3] + rowA[x*3 + 1] + rowA[x*3 + 2]) / 12);
+				rowOut[x*3 + 0] = rowOut[x*3 + 1] = rowOut[x*3 + 2] = grey;
+			}
+		}
+	}
+
+	diff->meanDelta = (double)totalDelta / ((double)diff->pixelCount * 3);
+
+	SDL_DestroySurface(a);
+	SDL_DestroySurface(b);
+	if (diffOut) *diffOut = out;
+
+	return true;
+}
@@ -0,0 +1,33 @@
+// Frame capture to PPM files and comparison against reference images
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_CAPTURE_H
+#define CUBERENDER_CAPTURE_H
+
+#include <SDL3/SDL_surface.h>
+
+// Fixed views along the bench camera path rendered by --capture / --compare
+#define CAPTURE_VIEWS				8
+
+// Largest per channel difference (0-255) that still counts as the same pixel
+#define CAPTURE_DEFAULT_TOLERANCE	8
+
+typedef struct {
+	int width, height;
+	int pixelCount;
+
+	int mismatched;		// pixels with any channel outside the tolerance
+	int maxDelta;		// largest channel difference seen
+	double meanDelta;	// mean absolute channel difference over the whole image
+} ImageDiff;
+
+// Surfaces passed in can be any format, they are converted to RGB24 first
+bool writePPM(const char* path, SDL_Surface* surface);
+SDL_Surface* readPPM(const char* path);
+
+// Returns false when the images can't be compared (different sizes).
+// diffOut (optional) gets a new RGB24 image : matching pixels as a dimmed greyscale of the reference,
+// mismatches in red scaled by how far off they are
+bool compareImages(SDL_Surface* reference, SDL_Surface* image, int tolerance, ImageDiff* diff, SDL_Surface** diffOut);
+
+#endif //CUBERENDER_CAPTURE_H
@@ -0,0 +1,171 @@
+// Clip space frustum tests and near plane clipping
+// Created by James Schaffer on 16/10/2026.
+
+#include "clip.h"
+
+#include <math.h>
+
+Uint8 clipOutcode(const v4 c) {
+	Uint8 code = 0;
+
+	if (c.x < -c.w) code |= CLIP_LEFT;
+	if (c.x > c.w) code |= CLIP_RIGHT;
+	if (c.y < -c.w) code |= CLIP_BOTTOM;
+	if (c.y > c.w) code |= CLIP_TOP;
+	if (c.z < 0) code |= CLIP_NEAR;
+	if (c.z > c.w) code |= CLIP_FAR;
+
+	return code;
+}
+
+static v4 lerpV4(const v4 a, const v4 b, const double t) {
+	v4 r;
+	r.x = a.x + (b.x - a.x) * t;
+	r.y = a.y + (b.y - a.y) * t;
+	r.z = a.z + (b.z - a.z) * t;
+	r.w = a.w + (b.w - a.w) * t;
+	return r;
+}
+
+// Sutherland-Hodgman against the near plane (z = 0 in clip space)
+// Returns the number of polygon corners written to out : 0 (fully clipped), 3 or 4
+int clipTriangleNear(const v4 in[3], const float* inAttrs, const int attrCount, v4 out[CLIP_MAX_POLY_VERTS], float* outAttrs) {
+	int n = 0;
+
+	for (int i=0; i<3; ++i) {
+		const int j = (i+1) % 3;
+		const v4 a = in[i];
+		const v4 b = in[j];
+
+		const bool aInside = a.z >= 0;
+		const bool bInside = b.z >= 0;
+
+		if (aInside) {
+			for (int k=0; k<attrCount; ++k) outAttrs[n * attrCount + k] = inAttrs[i * attrCount + k];
+			out[n++] = a;
+		}
+
+		// Edge crosses the plane, add the intersection
+		if (aInside != bInside) {
+			const double t = a.z / (a.z - b.z);
+
+			for (int k=0; k<attrCount; ++k) {
+				const float from = inAttrs[i * attrCount + k];
+				outAttrs[n * attrCount + k] = from + (inAttrs[j * attrCount + k] - from) * (float)t;
+			}
+			out[n++] = lerpV4(a, b, t);
+		}
+	}
+
+	return n;
+}
+
+// ========== WHOLE OBJECT TESTS ==========
+
+static v4 normalizePlane(const v4 p) {
+	const double len = sqrt(p.x*p.x + p.y*p.y + p.z*p.z);
+	if (len == 0.0) return p;
+
+	return (v4){ p.x / len, p.y / len, p.z / len, p.w / len };
+}
+
+// Frustum planes in whatever space m maps to clip space (world for viewProjection)
+Frustum frustumFromMatrix(const mat4* m) {
+	const double (*r)[4] = m->m;
+	Frustum f;
+
+	// Same order as the CLIP_* bits : -w<=x, x<=w, -w<=y, y<=w, 0<=z, z<=w
+	f.planes[0] = normalizePlane((v4){ r[3][0]+r[0][0], r[3][1]+r[0][1], r[3][2]+r[0][2], r[3][3]+r[0][3] });
+	f.planes[1] = normalizePlane((v4){ r[3][0]-r[0][0], r[3][1]-r[0][1], r[3][2]-r[0][2], r[3][3]-r[0][3] });
+	f.planes[2] = normalizePlane((v4){ r[3][0]+r[1][0], r[3][1]+r[1][1], r[3][2]+r[1][2], r[3][3]+r[1][3] });
+	f.planes[3] = normalizePlane((v4){ r[3][0]-r[1][0], r[3][1]-r[1][1], r[3][2]-r[1][2], r[3][3]-r[1][3] });
+	f.planes[4] = normalizePlane((v4){ r[2][0], r[2][1], r[2][2], r[2][3] });
+	f.planes[5] = normalizePlane((v4){ r[3][0]-r[2][0], r[3][1]-r[2][1], r[3][2]-r[2][2], r[3][3]-r[2][3] });
+
+	return f;
+}
+
+// True if the sphere is entirely outside at least one plane
+bool frustumCullSphere(const Frustum* frustum, const Sphere sphere) {
+	for (int i=0; i<6; ++i) {
+		const v4 p = frustum->planes[i];
+		const double dist = p.x*sphere.center.x + p.y*sphere.center.y + p.z*sphere.center.z + p.w;
+
+		if (dist < -sphere.radius) return true;
+	}
+
+	return false;
+}
+
+// World space box against the frustum planes using the nearest / furthest corner to each plane
+int frustumTestAABB(const Frustum* frustum, const AABB* box) {
+	int result = FRUSTUM_INSIDE;
+
+	for (int i=0; i<6; ++i) {
+		const v4 p = frustum->planes[i];
+
+		// Corner furthest along the plane normal
+		const v3 pos = {
+			p.x >= 0 ? box->max.x : box->min.x,
+			p.y >= 0 ? box->max.y : box->min.y,
+			p.z >= 0 ? box->max.z : box->min.z
+		};
+		if (p.x*pos.x + p.y*pos.y + p.z*pos.z + p.w < 0) return FRUSTUM_OUTSIDE;
+
+		const v3 neg = {
+			p.x >= 0 ? box->min.x : box->max.x,
+			p.y >= 0 ? box->min.y : box->max.y,
+			p.z >= 0 ? box->min.z : box->max.z
+		};
+		if (p.x*neg.x + p.y*neg.y + p.z*neg.z + p.w < 0) result = FRUSTUM_INTERSECT;
+	}
+
+	return result;
+}
+
+// True if all 8 corners of the object space box are outside the same clip plane
+bool clipCullAABB(const mat4* mvp, const AABB* box) {
+	Uint8 code = 0xFF;
+
+	for (int i=0; i<8; ++i) {
+		const v3 corner = {
+			(i & 1) ? box->max.x : box->min.x,
+			(i & 2) ? box->max.y : box->min.y,
+			(i & 4) ? box->max.z : box->min.z
+		};
+
+		code &= clipOutcode(mat4MulPoint(mvp, corner));
+		if (!code) return false;
+	}
+
+	return true;
+}
+
+// Object space sphere -> world space, the radius grows by the largest axis scale
+Sphere transformSphere(const Sphere sphere, const mat4* model) {
+	const v4 c = mat4MulPoint(model, sphere.center);
+
+	double maxScaleSq = 0;
+	for (int i=0; i<3; ++i) {
+		const double sq = model->m[0][i]*model->m[0][i] + model->m[1][i]*model->m[1][i] + model->m[2][i]*model->m[2][i];
+		if (sq > maxScaleSq) maxScaleSq = sq;
+	}
+
+	return (Sphere){ {c.x, c.y, c.z}, sphere.radius * sqrt(maxScaleSq) };
+}
+
+// Object space box -> world space box that contains it (center / extent form, absolute rotation)
+AABB transformAABB(const AABB* box, const mat4* model) {
+	const v3 center = v3Scale(v3Add(box->min, box->max), 0.5);
+	const v3 extent = v3Scale(v3Sub(box->max, box->min), 0.5);
+
+	const v4 c = mat4MulPoint(model, center);
+
+	v3 e;
+	e.x = fabs(model->m[0][0])*extent.x + fabs(model->m[0][1])*extent.y + fabs(model->m[0][2])*extent.z;
+	e.y = fabs(model->m[1][0])*extent.x + fabs(model->m[1][1])*extent.y + fabs(model->m[1][2])*extent.z;
+	e.z = fabs(model->m[2][0])*extent.x + fabs(model->m[2][1])*extent.y + fabs(model->m[2][2])*extent.z;
+
+	const v3 worldCenter = {c.x, c.y, c.z};
+	return (AABB){ v3Sub(worldCenter, e), v3Add(worldCenter, e) };
+}
@@ -0,0 +1,45 @@
+// Clip space frustum tests and near plane clipping
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_CLIP_H
+#define CUBERENDER_CLIP_H
+
+#include <SDL3/SDL_stdinc.h>
+
+#include "vector.h"
+
+// Outcode bits, set when a clip space point is outside that frustum plane
+// (clip space is -w <= x,y <= w and 0 <= z <= w)
+#define CLIP_LEFT	0x01
+#define CLIP_RIGHT	0x02
+#define CLIP_BOTTOM	0x04
+#define CLIP_TOP	0x08
+#define CLIP_NEAR	0x10
+#define CLIP_FAR	0x20
+
+// A triangle clipped by one plane has at most 4 corners
+#define CLIP_MAX_POLY_VERTS 4
+
+// frustumTestAABB results
+#define FRUSTUM_OUTSIDE		0
+#define FRUSTUM_INTERSECT	1
+#define FRUSTUM_INSIDE		2
+
+// Planes as (normal.xyz, d) with inside being dot(normal, p) + d >= 0
+typedef struct {
+	v4 planes[6];
+} Frustum;
+
+Uint8 clipOutcode(v4 c);
+
+Frustum frustumFromMatrix(const mat4* m);
+bool frustumCullSphere(const Frustum* frustum, Sphere sphere);
+int frustumTestAABB(const Frustum* frustum, const AABB* box);
+bool clipCullAABB(const mat4* mvp, const AABB* box);
+
+Sphere transformSphere(Sphere sphere, const mat4* model);
+AABB transformAABB(const AABB* box, const mat4* model);
+// inAttrs / outAttrs carry attrCount values per corner (corner after corner), interpolated along the clipped edges
+int clipTriangleNear(const v4 in[3], const float* inAttrs, int attrCount, v4 out[CLIP_MAX_POLY_VERTS], float* outAttrs);
+
+#endif //CUBERENDER_CLIP_H
@@ -0,0 +1,570 @@
+// Level of detail chains (quadric error simplification) and per object selection
+// Created by James Schaffer on 16/10/2026.
+
+#include "lod.h"
+#include "meshopt.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* allocOrDie(const size_t count, const size_t elemSize) {
+	void* ptr = calloc(count ? count : 1, elemSize);
+	if (!ptr) {
+		puts("Error allocating LOD buffer");
+		raise(SIGTERM);
+	}
+	return ptr;
+}
+
+static void* growOrDie(void* ptr, const size_t count, const size_t elemSize) {
+	void* newPtr = realloc(ptr, count * elemSize);
+	if (!newPtr) {
+		puts("Error resizing LOD buffer");
+		raise(SIGTERM);
+	}
+	return newPtr;
+}
+
+// ========== QUADRICS ==========
+// Garland & Heckbert, "Surface Simplification Using Quadric Error Metrics". Each vertex sums the squared
+// distance to the planes of its faces, a collapse costs the summed error at the merged position
+
+// Symmetric 4x4 : a2 ab ac ad b2 bc bd c2 cd d2
+typedef struct {
+	double q[10];
+} Quadric;
+
+static Quadric quadricFromPlane(const v3 n, const double d, const double weight) {
+	return (Quadric){{
+		weight * n.x * n.x, weight * n.x * n.y, weight * n.x * n.z, weight * n.x * d,
+		weight * n.y * n.y, weight * n.y * n.z, weight * n.y * d,
+		weight * n.z * n.z, weight * n.z * d,
+		weight * d * d
+	}};
+}
+
+static void quadricAdd(Quadric* a, const Quadric* b) {
+	for (int i=0; i<10; ++i) a->q[i] += b->q[i];
+}
+
+static double quadricError(const Quadric* Q, const v3 v) {
+	const double* q = Q->q;
+
+	return q[0]*v.x*v.x + 2*q[1]*v.x*v.y + 2*q[2]*v.x*v.z + 2*q[3]*v.x
+		+ q[4]*v.y*v.y + 2*q[5]*v.y*v.z + 2*q[6]*v.y
+		+ q[7]*v.z*v.z + 2*q[8]*v.z
+		+ q[9];
+}
+
+// Position with the least error, falls back to the better of the ends and the midpoint when the quadric
+// is singular (flat or straight regions)
+static v3 quadricOptimum(const Quadric* Q, const v3 a, const v3 b, double* error) {
+	const double* q = Q->q;
+
+	const double det = q[0] * (q[4]*q[7] - q[5]*q[5])
+		- q[1] * (q[1]*q[7] - q[5]*q[2])
+		+ q[2] * (q[1]*q[5] - q[4]*q[2]);
+
+	const double scale = q[0] + q[4] + q[7];
+
+	if (fabs(det) > 1e-12 * scale * scale * scale) {
+		// Cramer's rule on A x = -b
+		const double bx = -q[3], by = -q[6], bz = -q[8];
+		const double inv = 1.0 / det;
+
+		const v3 v = {
+			inv * (bx * (q[4]*q[7] - q[5]*q[5]) - q[1] * (by*q[7] - q[5]*bz) + q[2] * (by*q[5] - q[4]*bz)),
+			inv * (q[0] * (by*q[7] - bz*q[5]) - bx * (q[1]*q[7] - q[5]*q[2]) + q[2] * (q[1]*bz - by*q[2])),
+			inv * (q[0] * (q[4]*bz - q[5]*by) - q[1] * (q[1]*bz - by*q[2]) + bx * (q[1]*q[5] - q[4]*q[2]))
+		};
+
+		*error = quadricError(Q, v);
+		return v;
+	}
+
+	const v3 mid = v3Scale(v3Add(a, b), 0.5);
+	const double ea = quadricError(Q, a);
+	const double eb = quadricError(Q, b);
+	const double em = quadricError(Q, mid);
+
+	if (ea <= eb && ea <= em) {
+		*error = ea;
+		return a;
+	}
+	if (eb <= em) {
+		*error = eb;
+		return b;
+	}
+	*error = em;
+	return mid;
+}
+
+// ========== EDGE HEAP ==========
+
+// Stamps go stale when either end changes, stale entries are skipped when popped
+typedef struct {
+	double cost;
+	v3 target;
+	int a, b;
+	unsigned int stampA, stampB;
+} EdgeCollapse;
+
+typedef struct {
+	EdgeCollapse* items;
+	size_t count, capacity;
+} EdgeHeap;
+
+static void heapPush(EdgeHeap* heap, const EdgeCollapse edge) {
+	if (heap->count == heap->capacity) {
+		heap->capacity = heap->capacity ? heap->capacity * 2 : 256;
+		heap->items = growOrDie(heap->items, heap->capacity, sizeof(EdgeCollapse));
+	}
+
+	size_t i = heap->count++;
+	while (i > 0) {
+		const size_t parent = (i - 1) / 2;
+		if (heap->items[parent].cost <= edge.cost) break;
+
+		heap->items[i] = heap->items[parent];
+		i = parent;
+	}
+	heap->items[i] = edge;
+}
+
+static EdgeCollapse heapPop(EdgeHeap* heap) {
+	const EdgeCollapse top = heap->items[0];
+	const EdgeCollapse last = heap->items[--heap->count];
+
+	size_t i = 0;
+	for (;;) {
+		size_t child = i * 2 + 1;
+		if (child >= heap->count) break;
+		if (child + 1 < heap->count && heap->items[child + 1].cost < heap->items[child].cost) child++;
+		if (last.cost <= heap->items[child].cost) break;
+
+		heap->items[i] = heap->items[child];
+		i = child;
+	}
+	if (heap->count > 0) heap->items[i] = last;
+
+	return top;
+}
+
+// ========== SIMPLIFICATION ==========
+
+typedef struct {
+	int* faces;
+	int count, capacity;
+} FaceList;
+
+typedef struct {
+	v3* positions;
+	Quadric* quadrics;
+	FaceList* vertexFaces;
+	unsigned int* stamps;
+	bool* vertexAlive;
+
+	Tri* faces;
+	bool* faceAlive;
+	size_t liveFaces;
+
+	// Scratch for finding each vertex's neighbours once
+	int* mark;
+	int markValue;
+
+	EdgeHeap heap;
+} Simplifier;
+
+static void faceListPush(FaceList* list, const int face) {
+	if (list->count == list->capacity) {
+		list->capacity = list->capacity ? list->capacity * 2 : 8;
+		list->faces = growOrDie(list->faces, list->capacity, sizeof(int));
+	}
+	list->faces[list->count++] = face;
+}
+
+static bool faceHas(const Tri* t, const int v) {
+	return t->v0 == v || t->v1 == v || t->v2 == v;
+}
+
+static v3 faceNormal(const v3 a, const v3 b, const v3 c) {
+	return crossProduct(v3Sub(b, a), v3Sub(c, a));
+}
+
+static void pushEdge(Simplifier* s, const int a, const int b) {
+	Quadric q = s->quadrics[a];
+	quadricAdd(&q, &s->quadrics[b]);
+
+	EdgeCollapse edge;
+	edge.target = quadricOptimum(&q, s->positions[a], s->positions[b], &edge.cost);
+	edge.a = a;
+	edge.b = b;
+	edge.stampA = s->stamps[a];
+	edge.stampB = s->stamps[b];
+
+	heapPush(&s->heap, edge);
+}
+
+// Queues an edge from v to each live neighbour, onlyHigher keeps the initial pass from adding each edge twice
+static void pushVertexEdges(Simplifier* s, const int v, const bool onlyHigher) {
+	s->markValue++;
+
+	const FaceList* list = &s->vertexFaces[v];
+	for (int i=0; i<list->count; ++i) {
+		if (!s->faceAlive[list->faces[i]]) continue;
+
+		const Tri* t = &s->faces[list->faces[i]];
+		const int corners[3] = { t->v0, t->v1, t->v2 };
+
+		for (int k=0; k<3; ++k) {
+			const int n = corners[k];
+			if (n == v || s->mark[n] == s->markValue) continue;
+			if (onlyHigher && n < v) continue;
+
+			s->mark[n] = s->markValue;
+			pushEdge(s, v, n);
+		}
+	}
+}
+
+// Face and boundary quadrics for every vertex
+static void initQuadrics(Simplifier* s, const size_t vertexCount, const size_t faceCount) {
+	for (size_t f=0; f<faceCount; ++f) {
+		const Tri* t = &s->faces[f];
+		const v3 n = faceNormal(s->positions[t->v0], s->positions[t->v1], s->positions[t->v2]);
+		const double len = v3Len(n);
+		if (len <= 0.0) continue;
+
+		// Area weighted so big faces hold their shape more than slivers
+		const v3 unit = v3Scale(n, 1.0 / len);
+		const Quadric q = quadricFromPlane(unit, -dotProduct(unit, s->positions[t->v0]), len * 0.5);
+
+		quadricAdd(&s->quadrics[t->v0], &q);
+		quadricAdd(&s->quadrics[t->v1], &q);
+		quadricAdd(&s->quadrics[t->v2], &q);
+	}
+
+	// An edge used by one face is on a boundary, a plane through it at right angles to the face stops it
+	// being pulled inwards
+	int* edgeUses = allocOrDie(vertexCount, sizeof(int));
+	int* edgeFace = allocOrDie(vertexCount, sizeof(int));
+
+	for (size_t v=0; v<vertexCount; ++v) {
+		const FaceList* list = &s->vertexFaces[v];
+		s->markValue++;
+
+		for (int i=0; i<list->count; ++i) {
+			const Tri* t = &s->faces[list->faces[i]];
+			const int corners[3] = { t->v0, t->v1, t->v2 };
+
+			for (int k=0; k<3; ++k) {
+				const int n = corners[k];
+				if (n == (int)v) continue;
+
+				if (s->mark[n] != s->markValue) {
+					s->mark[n] = s->markValue;
+					edgeUses[n] = 0;
+				}
+				edgeUses[n]++;
+				edgeFace[n] = list->faces[i];
+			}
+		}
+
+		for (int i=0; i<list->count; ++i) {
+			const Tri* t = &s->faces[list->faces[i]];
+			const int corners[3] = { t->v0, t->v1, t->v2 };
+
+			for (int k=0; k<3; ++k) {
+				const int n = corners[k];
+				if (n <= (int)v || edgeUses[n] != 1) continue;
+				edgeUses[n] = 0; // once per edge
+
+				const Tri* f = &s->faces[edgeFace[n]];
+				const v3 faceN = normalize(faceNormal(s->positions[f->v0], s->positions[f->v1], s->positions[f->v2]));
+				const v3 edge = v3Sub(s->positions[n], s->positions[v]);
+				const v3 planeN = normalize(crossProduct(edge, faceN));
+
+				const double edgeLenSq = dotProduct(edge, edge);
+				const Quadric q = quadricFromPlane(planeN, -dotProduct(planeN, s->positions[v]), LOD_BOUNDARY_WEIGHT * edgeLenSq);
+
+				quadricAdd(&s->quadrics[v], &q);
+				quadricAdd(&s->quadrics[n], &q);
+			}
+		}
+	}
+
+	free(edgeUses);
+	free(edgeFace);
+}
+
+// Moving v to target must not flip or crush any face that survives the collapse
+static bool collapseFlips(const Simplifier* s, const int v, const int other, const v3 target) {
+	const FaceList* list = &s->vertexFaces[v];
+
+	for (int i=0; i<list->count; ++i) {
+		const int f = list->faces[i];
+		if (!s->faceAlive[f]) continue;
+
+		const Tri* t = &s->faces[f];
+		if (faceHas(t, other)) continue; // removed by the collapse
+
+		v3 p[3] = { s->positions[t->v0], s->positions[t->v1], s->positions[t->v2] };
+		const v3 before = faceNormal(p[0], p[1], p[2]);
+
+		if (t->v0 == v) p[0] = target;
+		if (t->v1 == v) p[1] = target;
+		if (t->v2 == v) p[2] = target;
+
+		const v3 after = faceNormal(p[0], p[1], p[2]);
+
+		const double lenBefore = v3Len(before), lenAfter = v3Len(after);
+		if (lenAfter <= 1e-12 * (lenBefore + 1e-30)) return true;
+		if (dotProduct(before, after) < LOD_MAX_FLIP_DOT * lenBefore * lenAfter) return true;
+	}
+
+	return false;
+}
+
+// b is merged into a at target
+static void collapseEdge(Simplifier* s, const int a, const int b, const v3 target) {
+	s->positions[a] = target;
+	quadricAdd(&s->quadrics[a], &s->quadrics[b]);
+	s->stamps[a]++;
+	s->vertexAlive[b] = false;
+
+	FaceList* listB = &s->vertexFaces[b];
+
+	for (int i=0; i<listB->count; ++i) {
+		const int f = listB->faces[i];
+		if (!s->faceAlive[f]) continue;
+
+		Tri* t = &s->faces[f];
+
+		if (faceHas(t, a)) {
+			s->faceAlive[f] = false;
+			s->liveFaces--;
+			continue;
+		}
+
+		if (t->v0 == b) t->v0 = a;
+		if (t->v1 == b) t->v1 = a;
+		if (t->v2 == b) t->v2 = a;
+
+		faceListPush(&s->vertexFaces[a], f);
+	}
+
+	free(listB->faces);
+	*listB = (FaceList){0};
+
+	// Drop dead faces so lists don't grow with every collapse
+	FaceList* listA = &s->vertexFaces[a];
+	int kept = 0;
+	for (int i=0; i<listA->count; ++i) {
+		if (s->faceAlive[listA->faces[i]]) listA->faces[kept++] = listA->faces[i];
+	}
+	listA->count = kept;
+
+	pushVertexEdges(s, a, false);
+}
+
+// Collapses the cheapest edges of src until it has targetFaces faces (or nothing more can go). out gets its
+// own arrays, faces keep the normals, texcoords and material they had in src
+void simplifyMesh(const Mesh* src, const size_t targetFaces, Mesh* out) {
+	const size_t vertexCount = src->vertexCount;
+	const size_t faceCount = src->faceCount;
+
+	*out = (Mesh){0};
+	out->color = src->color;
+
+	Simplifier s = {0};
+	s.positions = allocOrDie(vertexCount, sizeof(v3));
+	s.quadrics = allocOrDie(vertexCount, sizeof(Quadric));
+	s.vertexFaces = allocOrDie(vertexCount, sizeof(FaceList));
+	s.stamps = allocOrDie(vertexCount, sizeof(unsigned int));
+	s.vertexAlive = allocOrDie(vertexCount, sizeof(bool));
+	s.mark = allocOrDie(vertexCount, sizeof(int));
+	s.faces = allocOrDie(faceCount, sizeof(Tri));
+	s.faceAlive = allocOrDie(faceCount, sizeof(bool));
+
+	if (vertexCount) memcpy(s.positions, src->vertices, vertexCount * sizeof(v3));
+	if (faceCount) memcpy(s.faces, src->faces, faceCount * sizeof(Tri));
+
+	for (size_t v=0; v<vertexCount; ++v) s.vertexAlive[v] = true;
+
+	for (size_t f=0; f<faceCount; ++f) {
+		const Tri* t = &s.faces[f];
+
+		// Already degenerate faces are dropped up front
+		s.faceAlive[f] = t->v0 != t->v1 && t->v1 != t->v2 && t->v0 != t->v2;
+		if (!s.faceAlive[f]) continue;
+
+		s.liveFaces++;
+		faceListPush(&s.vertexFaces[t->v0], (int)f);
+		faceListPush(&s.vertexFaces[t->v1], (int)f);
+		faceListPush(&s.vertexFaces[t->v2], (int)f);
+	}
+
+	initQuadrics(&s, vertexCount, faceCount);
+
+	for (size_t v=0; v<vertexCount; ++v) {
+		pushVertexEdges(&s, (int)v, true);
+	}
+
+	while (s.liveFaces > targetFaces && s.heap.count > 0) {
+		const EdgeCollapse edge = heapPop(&s.heap);
+
+		if (!s.vertexAlive[edge.a] || !s.vertexAlive[edge.b]) continue;
+		if (edge.stampA != s.stamps[edge.a] || edge.stampB != s.stamps[edge.b]) continue;
+
+		if (collapseFlips(&s, edge.a, edge.b, edge.target) || collapseFlips(&s, edge.b, edge.a, edge.target)) continue;
+
+		collapseEdge(&s, edge.a, edge.b, edge.target);
+	}
+
+	// Compact the survivors, vertices and normals renumbered in the order faces use them
+	int* vertexRemap = allocOrDie(vertexCount, sizeof(int));
+	int* normalRemap = allocOrDie(src->normalCount, sizeof(int));
+	int* texcoordRemap = allocOrDie(src->texcoordCount, sizeof(int));
+	memset(vertexRemap, 0xFF, vertexCount * sizeof(int));
+	memset(normalRemap, 0xFF, src->normalCount * sizeof(int));
+	memset(texcoordRemap, 0xFF, src->texcoordCount * sizeof(int));
+
+	out->faces = allocOrDie(s.liveFaces, sizeof(Tri));
+	out->vertices = allocOrDie(vertexCount, sizeof(v3));
+	out->normals = allocOrDie(src->normalCount, sizeof(v3));
+	out->texcoords = src->texcoordCount ? allocOrDie(src->texcoordCount, sizeof(v2)) : NULL;
+
+	for (size_t f=0; f<faceCount; ++f) {
+		if (!s.faceAlive[f]) continue;
+
+		Tri t = s.faces[f];
+		int* corners[3] = { &t.v0, &t.v1, &t.v2 };
+
+		for (int k=0; k<3; ++k) {
+			const int v = *corners[k];
+			if (vertexRemap[v] < 0) {
+				vertexRemap[v] = (int)out->vertexCount;
+				out->vertices[out->vertexCount++] = s.positions[v];
+			}
+			*corners[k] = vertexRemap[v];
+		}
+
+		int* normals[3] = { &t.n0, &t.n1, &t.n2 };
+
+		for (int k=0; k<3; ++k) {
+			const int n = *normals[k];
+			if (normalRemap[n] < 0) {
+				normalRemap[n] = (int)out->normalCount;
+				out->normals[out->normalCount++] = src->normals[n];
+			}
+			*normals[k] = normalRemap[n];
+		}
+
+		int* texcoords[3] = { &t.t0, &t.t1, &t.t2 };
+
+		for (int k=0; k<3; ++k) {
+			const int tc = *texcoords[k];
+			if (tc < 0) continue;
+
+			if (texcoordRemap[tc] < 0) {
+				texcoordRemap[tc] = (int)out->texcoordCount;
+				out->texcoords[out->texcoordCount++] = src->texcoords[tc];
+			}
+			*texcoords[k] = texcoordRemap[tc];
+		}
+
+		out->faces[out->faceCount++] = t;
+	}
+
+	for (size_t v=0; v<vertexCount; ++v) free(s.vertexFaces[v].faces);
+
+	free(s.positions);
+	free(s.quadrics);
+	free(s.vertexFaces);
+	free(s.stamps);
+	free(s.vertexAlive);
+	free(s.mark);
+	free(s.faces);
+	free(s.faceAlive);
+	free(s.heap.items);
+	free(vertexRemap);
+	free(normalRemap);
+	free(texcoordRemap);
+
+	// Same material list as src, the library entries are bound with src's (bindMeshMaterials)
+	if (src->materialCount > 0) {
+		out->materialNames = allocOrDie(src->materialCount, sizeof(MeshMaterialName));
+		memcpy(out->materialNames, src->materialNames, src->materialCount * sizeof(MeshMaterialName));
+		out->materialCount = src->materialCount;
+	}
+	memcpy(out->materialLibrary, src->materialLibrary, sizeof(out->materialLibrary));
+
+	computeMeshBounds(out);
+}
+
+// ========== CHAIN ==========
+
+// Each level is simplified from the one before it, then reordered for the vertex cache like the full mesh
+void buildMeshLODs(Mesh* mesh) {
+	if (mesh->lods || mesh->faceCount < LOD_MIN_FACES) return;
+
+	static const double ratios[LOD_LEVELS] = LOD_RATIOS;
+
+	mesh->lods = allocOrDie(LOD_LEVELS, sizeof(Mesh));
+	mesh->lodCount = 0;
+
+	const Mesh* previous = mesh;
+
+	for (int i=0; i<LOD_LEVELS; ++i) {
+		const size_t target = (size_t)(mesh->faceCount * ratios[i]);
+		if (target < 4 || target >= previous->faceCount) break;
+
+		Mesh* lod = &mesh->lods[mesh->lodCount];
+		simplifyMesh(previous, target, lod);
+
+		// Nothing collapsed, coarser levels won't manage either
+		if (lod->faceCount >= previous->faceCount) {
+			freeMeshData(lod);
+			break;
+		}
+
+		// Survivors keep src's order so they're still grouped, the ranges only need finding again
+		buildMeshFaceRanges(lod);
+		optimizeFaceOrder(lod);
+		reorderVerticesByFirstUse(lod);
+
+		mesh->lodCount++;
+		previous = lod;
+	}
+}
+
+// ========== SELECTION ==========
+
+// Level 0 is the full mesh, level i is lods[i-1]. Moves at most as far as the radius says, but only past a
+// threshold once the radius is LOD_HYSTERESIS beyond it
+int selectMeshLOD(const Mesh* mesh, int current, const double screenRadius) {
+	static const double radii[LOD_LEVELS] = LOD_SCREEN_RADII;
+
+	if (current > mesh->lodCount) current = mesh->lodCount;
+	if (current < 0) current = 0;
+
+	// Finer while the radius is clearly above the threshold into the current level
+	while (current > 0 && screenRadius > radii[current - 1] * (1.0 + LOD_HYSTERESIS)) {
+		current--;
+	}
+
+	// Coarser while it's clearly below the threshold out of it
+	while (current < mesh->lodCount && screenRadius < radii[current] * (1.0 - LOD_HYSTERESIS)) {
+		current++;
+	}
+
+	return current;
+}
+
+const Mesh* getMeshLOD(const Mesh* mesh, const int lod) {
+	if (lod <= 0 || lod > mesh->lodCount) return mesh;
+	return &mesh->lods[lod - 1];
+}
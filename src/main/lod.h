@@ -0,0 +1,34 @@
+// Level of detail chains (quadric error simplification) and per object selection
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_LOD_H
+#define CUBERENDER_LOD_H
+
+#include "mesh.h"
+
+// Simplified levels built per mesh, as fractions of the full mesh's face count
+#define LOD_LEVELS		3
+#define LOD_RATIOS		{ 0.5, 0.25, 0.1 }
+
+// Meshes this small aren't worth simplifying
+#define LOD_MIN_FACES	64
+
+// Projected radius (pixels) below which each coarser level takes over, one per LOD_RATIOS entry
+#define LOD_SCREEN_RADII	{ 240.0, 120.0, 48.0 }
+
+// Switching needs the radius to get this fraction past a threshold, so objects sitting on one don't flicker
+#define LOD_HYSTERESIS	0.15
+
+// Faces whose normal would turn more than this (dot product) in a collapse block it
+#define LOD_MAX_FLIP_DOT 0.2
+
+// Boundary edges get planes this much heavier than faces so open edges keep their outline
+#define LOD_BOUNDARY_WEIGHT 100.0
+
+void buildMeshLODs(Mesh* mesh);
+void simplifyMesh(const Mesh* src, size_t targetFaces, Mesh* out);
+
+int selectMeshLOD(const Mesh* mesh, int current, double screenRadius);
+const Mesh* getMeshLOD(const Mesh* mesh, int lod);
+
+#endif //CUBERENDER_LOD_H
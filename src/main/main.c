@@ -1,8 +1,23 @@
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <SDL3/SDL.h>
 
+#include "arena.h"
+#include "batch.h"
+#include "bench.h"
+#include "capture.h"
+#include "clip.h"
+#include "lod.h"
+#include "material.h"
 #include "mesh.h"
+#include "occlusion.h"
+#include "profiler.h"
+#include "project.h"
+#include "raster.h"
+#include "scene.h"
+#include "sort.h"
 #include "vector.h"
 #include "window.h"
 
@@ -28,8 +43,33 @@ const double PI_2 = 1.5707963267948966192;
 #define SDL_WINDOW_WIDTH	1920U
 #define SDL_WINDOW_HEIGHT	1080U
 
+// Only render when the camera, meshes, window or render options changed, sleeping on events otherwise.
+// 0 renders every loop iteration (bench mode always does)
+#define REDRAW_ON_CHANGE	1
+
+// Longest an idle window sleeps before checking again
+#define IDLE_WAIT_MS		500
+
+// Brightness of a vertex facing away from the sun
+#define AMBIENT_LIGHT		0.1f
+
 #define CAM_FOV				(PI/2) // 90 degrees
 #define CAM_CLIP_MIN		0.5
+#define CAM_CLIP_MAX		1000.0
+
+// Starting sizes of the scratch arenas, both grow to their high water mark if a frame needs more
+#define FRAME_ARENA_SIZE	(1U << 20)
+#define MESH_ARENA_SIZE		(1U << 20)
+
+// Visible objects whose projected radius is at least OCCLUDER_MIN_RADIUS pixels are drawn into the occlusion
+// buffer before anything else, the MAX_OCCLUDERS biggest of them. Every other object is tested against it
+#define OCCLUDER_MIN_RADIUS	150.0
+#define MAX_OCCLUDERS		8
+
+// Draw state keys (see drawStateKey) : blend mode in the top bit, then the texture, its mip level, then the mesh
+#define DRAW_KEY_TEXTURE_BITS	11
+#define DRAW_KEY_LEVEL_BITS		4
+#define DRAW_KEY_MESH_BITS		16
 
 #define MAX_VERTEX			10000U
 #define MAX_FACES			10000U
@@ -42,19 +82,57 @@ typedef struct  {
 	v3 defNormal;
 	v3 defUp;
 } CamState;
+typedef struct {
+	int objectsTotal;
+	int bvhCulled;
+	int meshesTested;
+	int sphereCulled;
+	int boxCulled;
+	int occluded;
+} CullStats;
 typedef struct {
 	v3 position;
-	v3 planePosition;
 	v3 normalV;
 	v3 upV;
 	v3 rightV;
-	double fov_scale;
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
 } CamProjectionInfo;
 
+// One mesh made ready to draw : culled as a whole, projected and lit. Arrays come from the arena it was prepared in
+typedef struct {
+	const Mesh* mesh;
+	mat4 model;
+	mat4 mvp;
+	mat4 normalMatrix;
+
+	// Camera in object space for the face plane test, only when the model matrix has an inverse
+	bool objectSpaceCull;
+	v3 camObject;
+
+	ProjectedVertices projected;
+	float* light;
+} MeshDraw;
+// Faces of one material range of one draw, and for a textured range only those using one mip level
+typedef struct {
+	int draw;
+	MeshFaceRange range;
+
+	// Face indices when the range was split by level, NULL for range.first onwards
+	const int* faces;
+} DrawItem;
+
 // ========== OTHER VARS ==========
 
 bool gameRunning = true;
 
+// Set by input / window events that change the picture without moving the camera or meshes
+bool redrawRequested = true;
+
+// Whole mesh frustum rejections, printed with the fps
+CullStats cullStats = {0};
+
 // ========== INPUT BOOLS ==========
 // Rotation
 bool spaceDown = false;
@@ -77,96 +155,142 @@ bool dDown = false;
 bool eDown = false;
 bool qDown = false;
 
+// Render options
+bool pDown = false;
+bool painterSort = true;
+
+bool rDown = false;
+bool softwareRaster = false;
+
+bool lDown = false;
+bool useLods = true;
+
+bool cDown = false;
+bool occlusionCulling = true;
+
+// Profiler overlay
+bool oDown = false;
+
 // ========== CAMERA TRANSFORM ==========
 
 CamState cam = {{0, -2, 0}, {0,0,0}, {0,1,0}, {0,0,1}};
 
 // Other
 
+// Direction the sunlight travels
 v3 sun = {0, 1, -1};
 Transform meshTrans = { {0,0,0}, {0,0,0}, {1,1,1}};
 
-// ========== SETUP CAM PROJECTION VARS FOR EACH FRAME ==========
+// Scratch memory, frameArena is reset after each frame and meshArena after each mesh.
+// Everything transient in render() comes out of these so a steady-state frame never touches the heap
+Arena frameArena;
+Arena meshArena;
 
-CamProjectionInfo getCamProjectionInfo(const CamState* camera) {
-	CamProjectionInfo ret;
+#if ARENA_DEBUG
+Uint64 frameNumber = 0;
+Uint64 arenaHeapCalls = 0;
+#endif
 
-	ret.position = camera->position;
+// Re-used every frame for submitting triangles
+RenderBatch batch;
 
-	Transform camTransform = {
-		{0,0,0},
-		camera->rotation,
-		{1,1,1}
-	};
+// Per mesh face ordering by depth for painter's (back to front)
+SortBuffer faceSort;
 
-	ret.normalV = normalize(transformV3(&camera->defNormal,&camTransform));
-	ret.upV = normalize(transformV3(&camera->defUp,&camTransform));
+// Material ranges of every visible mesh ordered by drawStateKey, used whenever painter's order isn't needed
+SortBuffer stateSort;
 
-	// Projection plane
-	const v3 scaledNormal = v3Scale(ret.normalV, CAM_CLIP_MIN);
-	const v3 planePoint = v3Add(camera->position, scaledNormal);
+// Texture and blend mode of the last triangle submitted, for counting state changes
+const TextureLevel* boundTexture = NULL;
+SDL_BlendMode boundBlendMode = SDL_BLENDMODE_NONE;
+bool drawStateBound = false;
 
-	ret.planePosition = planePoint;
+// Per object offset added to meshTrans, only set when the scene has instances
+v3* objectOffsets = NULL;
 
-	// Right vector
-	ret.rightV = normalize(crossProduct(ret.upV, ret.normalV));
+// Visible scene objects, drawn back to front while painterSort is on
+SortBuffer objectSort;
 
-	// fov scale
-	ret.fov_scale = SDL_WINDOW_WIDTH / (2 * tan(CAM_FOV / 2));
+// Occluder candidates (indices into objectSort), biggest on screen first
+SortBuffer occluderSort;
 
-	return ret;
-}
+// Materials from the loaded file's mtllib, meshes point into it
+MaterialLibrary materialLibrary = {0};
 
-// ========== PROJECT A POINT IN 3D SPACE TO A 2D POSITION ON SCREEN ==========
+// Software rasterizer backend (z-buffered, replaces SDL_RenderGeometry when softwareRaster is on)
+Rasterizer* rasterizer = NULL;
 
-int project3DtoScreen(const v3 point, const CamProjectionInfo* camState, v2* outV) {
-	// Ray
-	const v3 ray = normalize(v3Sub(point, camState->position));
+// Coarse depth of the frame's biggest objects, everything else is tested against it before being prepared
+OcclusionBuffer occlusion;
 
-	// given t = (a-p0).n / v.n (a=planeCenter , p0=camPos, n=normal, v=rayVector(normalized))
+// Frame capture, render() reads the finished frame back into capturedFrame when captureNextFrame is set
+bool captureNextFrame = false;
+SDL_Surface* capturedFrame = NULL;
 
-	const double vn = dotProduct(ray, camState->normalV);
-	if (fabs(vn) < 1e-6) return 0; // parallel to plane (fabs = float absolute value)
+// ========== SETUP CAM PROJECTION VARS FOR EACH FRAME ==========
 
-	const double t = dotProduct(v3Sub(camState->planePosition, camState->position), camState->normalV) / vn;
-	if (t <= 0.0) return 0; // Behind camera
+CamProjectionInfo getCamProjectionInfo(const CamState* camera) {
+	CamProjectionInfo ret;
+
+	ret.position = camera->position;
 
-	// Find intersection point
-	v3 hit = v3Add(camState->position, v3Scale(ray, t));
+	const mat4 camRotation = mat4Rotation(camera->rotation);
 
-	// Find local intersection point (relative to plane center)
-	const v3 hit_planeSpace = v3Sub(hit, camState->planePosition);
+	ret.normalV = normalize(mat4MulDir(&camRotation, camera->defNormal));
+	ret.upV = normalize(mat4MulDir(&camRotation, camera->defUp));
 
-	// Find x y coords on plane for intersection (0,0 center and + axis is up and right)
-	double x = dotProduct(hit_planeSpace, camState->rightV);
-	double y = dotProduct(hit_planeSpace, camState->upV);
+	// Right vector
+	ret.rightV = normalize(crossProduct(ret.upV, ret.normalV));
+
+	// World -> view -> clip, every vertex then only needs the model matrix on top
+	ret.view = mat4LookAt(camera->position, v3Add(camera->position, ret.normalV), ret.upV);
+	ret.projection = mat4Perspective(CAM_FOV, (double)SDL_WINDOW_WIDTH / SDL_WINDOW_HEIGHT, CAM_CLIP_MIN, CAM_CLIP_MAX);
+	ret.viewProjection = mat4Mul(&ret.projection, &ret.view);
+
+	return ret;
+}
 
-	x *= camState->fov_scale;
-	y *= camState->fov_scale;
+// ========== MAP A CLIP SPACE POINT TO A 2D POSITION ON SCREEN ==========
 
-	// the dot product gives x and y where 0 is center of screen so :
+// Only valid for points in front of the near plane (clip.z >= 0)
+v2 clipToScreen(const v4 clip) {
+	// Perspective divide
+	const double invW = 1.0 / clip.w;
+
+	// ndc gives x and y where 0 is center of screen so :
 	// re-map 0,0 to top left and + axis to right down
-	outV->x = x + SDL_WINDOW_WIDTH / 2;
-	outV->y = y + SDL_WINDOW_HEIGHT / 2;
+	v2 ret;
+	ret.x = (1.0 + clip.x * invW) * (SDL_WINDOW_WIDTH / 2.0);
+	ret.y = (1.0 + clip.y * invW) * (SDL_WINDOW_HEIGHT / 2.0);
 
-	return 1;
+	return ret;
 }
 
-// ========== Projects an array of points to the screen ==========
+// ========== PROJECTS EVERY VERTEX OF A MESH ONCE PER FRAME ==========
+
+// Double precision path for meshes without a SoA mirror (see projectSoA for the SIMD path)
+void projectMeshVertices(const Mesh* mesh, const mat4* mvp, ProjectedVertices* out) {
+	for (size_t i=0; i<mesh->vertexCount; ++i) {
+		const v4 clip = mat4MulPoint(mvp, mesh->vertices[i]);
+		const v2 point = clipToScreen(clip);
 
-void projectPoints3DtoScreen(const v3* v, v2* projected, const int n, const CamState* camState) {
-	const CamProjectionInfo camInfo = getCamProjectionInfo(camState);
+		out->x[i] = (float)point.x;
+		out->y[i] = (float)point.y;
+		out->depth[i] = (float)clip.w;
+		out->outcode[i] = clipOutcode(clip);
+	}
+}
 
-	for (int i=0; i<n; ++i) {
-		v2 projectionPoint;
+// Double precision version of lightSoA, same sun + ambient per normal
+void lightMeshNormals(const Mesh* mesh, const mat4* normalMatrix, const v3 lightDir, float* out) {
+	for (size_t i=0; i<mesh->normalCount; ++i) {
+		const v3 normal = mat4MulDir(normalMatrix, mesh->normals[i]);
+		const double len = v3Len(normal);
 
-		int out = project3DtoScreen(v[i], &camInfo, &projectionPoint);
+		double d = len > 0 ? -dotProduct(normal, lightDir) / len : 0;
+		if (d < 0) d = 0;
 
-		if (out==1) projected[i] = projectionPoint;
-		else {
-			projected[i].x = 0;
-			projected[i].y = 0;
-		};
+		out[i] = (float)(AMBIENT_LIGHT + (1.0 - AMBIENT_LIGHT) * d);
 	}
 }
 
@@ -239,66 +363,823 @@ void update(double delta) {
 	}
 }
 
+// Scripted camera for --bench : one orbit of the scene while dollying between 1.2 and 4 bounding radii,
+// with the meshes spinning. Only depends on the frame number so every run draws the same frames
+void benchPath(const int frame, const int frameCount, const AABB* sceneBounds) {
+	const double t = (double)frame / frameCount;
+
+	const v3 center = v3Scale(v3Add(sceneBounds->min, sceneBounds->max), 0.5);
+	double radius = v3Len(v3Sub(sceneBounds->max, center));
+	if (radius < 0.5) radius = 0.5;
+
+	const double angle = 2 * PI * t;
+	const double dist = radius * (2.6 + 1.4 * sin(4 * PI * t));
+
+	// Yaw only, the camera looks along +y rotated about z
+	cam.rotation = (v3){0, 0, angle};
+	cam.position = v3Add(center, (v3){ dist * sin(angle), -dist * cos(angle), 0 });
+
+	meshTrans.rotation = (v3){ 2 * PI * t, 1.5 * PI * t, PI * t };
+}
+
+// meshTrans (spin / scale keys, bench path) moves every object, instances keep their place in the field
+void applyMeshTrans(Scene* scene) {
+	for (int i=0; i<scene->objectCount; ++i) {
+		Transform transform = meshTrans;
+		if (objectOffsets) {
+			transform.position = v3Add(transform.position, objectOffsets[i]);
+		}
+
+		sceneSetTransform(scene, i, transform);
+	}
+}
+
 // ===== RENDER FRAME =====
-void render(SDL_Renderer* renderer, Mesh mesh) {
+
+// Sends one screen space triangle to the active backend, texture is NULL when untextured.
+// The rasterizer draws everything opaque, blendMode only matters to SDL_RenderGeometry
+void submitTri(SDL_Renderer* renderer, const int ids[3], const TextureLevel* texture, const SDL_BlendMode blendMode,
+	const SDL_Vertex verts[3], const float invW[3]) {
+	PROFILE_COUNT(PROFILE_COUNTER_TRIS_SUBMITTED, 1);
+
+	// Every switch is a flush and rebind for the batch
+	if (!drawStateBound || texture != boundTexture || blendMode != boundBlendMode) {
+		PROFILE_COUNT(PROFILE_COUNTER_STATE_CHANGES, 1);
+		boundTexture = texture;
+		boundBlendMode = blendMode;
+		drawStateBound = true;
+	}
+
+	if (softwareRaster) {
+		rasterAddTri(rasterizer, verts, invW, texture);
+		return;
+	}
+
+	batchAddTri(&batch, renderer, texture ? texture->gpu : NULL, blendMode, ids, verts);
+}
+
+// Per corner values carried through clipping : light, u, v
+#define CORNER_ATTRIBUTES 3
+
+static SDL_FColor shadeColor(const float shade, const SDL_FColor diffuse) {
+	return (SDL_FColor){ shade * diffuse.r, shade * diffuse.g, shade * diffuse.b, diffuse.a };
+}
+
+// Library entry for one of the mesh's materials, NULL before any usemtl or when the library doesn't have it
+static const Material* meshMaterial(const Mesh* mesh, const int material) {
+	return material >= 0 && mesh->materials ? mesh->materials[material] : NULL;
+}
+
+// Diffuse map of a face, NULL when untextured or the face has no texture coordinates
+static const Texture* faceTexture(const Material* material, const Tri face) {
+	return material && face.t0 >= 0 && face.t1 >= 0 && face.t2 >= 0 ? material->diffuseMap : NULL;
+}
+
+// Mip level from how many texels land on each pixel of the projected face. Faces crossing the camera plane
+// are as close as anything gets, so they always get the full size level
+static int faceTextureLevel(const MeshDraw* draw, const Tri face, const Texture* texture) {
+	const ProjectedVertices* projected = &draw->projected;
+
+	if ((projected->outcode[face.v0] | projected->outcode[face.v1] | projected->outcode[face.v2]) & CLIP_NEAR) return 0;
+
+	const v2* texcoords = draw->mesh->texcoords;
+	const v2 t0 = texcoords[face.t0], t1 = texcoords[face.t1], t2 = texcoords[face.t2];
+
+	const float uvArea = 0.5f * fabsf((float)((t1.x - t0.x) * (t2.y - t0.y) - (t1.y - t0.y) * (t2.x - t0.x)));
+	const float screenArea = 0.5f * fabsf(
+		(projected->x[face.v1] - projected->x[face.v0]) * (projected->y[face.v2] - projected->y[face.v0]) -
+		(projected->y[face.v1] - projected->y[face.v0]) * (projected->x[face.v2] - projected->x[face.v0]));
+
+	return textureLevelForArea(texture, uvArea, screenArea);
+}
+
+// Clips a face crossing the near plane in clip space, giving up to 2 triangles
+void submitClippedFace(SDL_Renderer* renderer, const MeshDraw* draw, const Tri face, const float attrs[3 * CORNER_ATTRIBUTES],
+	const SDL_FColor diffuse, const TextureLevel* texture, const SDL_BlendMode blendMode) {
+	const v4 in[3] = {
+		mat4MulPoint(&draw->mvp, draw->mesh->vertices[face.v0]),
+		mat4MulPoint(&draw->mvp, draw->mesh->vertices[face.v1]),
+		mat4MulPoint(&draw->mvp, draw->mesh->vertices[face.v2])
+	};
+
+	v4 poly[CLIP_MAX_POLY_VERTS];
+	float polyAttrs[CLIP_MAX_POLY_VERTS * CORNER_ATTRIBUTES];
+	const int n = clipTriangleNear(in, attrs, CORNER_ATTRIBUTES, poly, polyAttrs);
+
+	// New corners don't exist in the mesh so they can't be shared
+	const int ids[3] = {-1, -1, -1};
+
+	// Fan triangulate (0,1,2) (0,2,3)
+	for (int k=1; k+1<n; ++k) {
+		const int corner[3] = { 0, k, k+1 };
+
+		SDL_Vertex verts[3];
+		float invW[3];
+
+		for (int j=0; j<3; ++j) {
+			const v4 c = poly[corner[j]];
+			const float* a = &polyAttrs[corner[j] * CORNER_ATTRIBUTES];
+			const v2 p = clipToScreen(c);
+
+			verts[j] = (SDL_Vertex){ {p.x, p.y}, shadeColor(a[0], diffuse), {a[1], a[2]} };
+			invW[j] = 1.0f / c.w;
+		}
+
+		submitTri(renderer, ids, texture, blendMode, verts, invW);
+	}
+}
+
+// Adds one face, each corner shaded by the light of its own normal and tinted by the face's material
+void submitFace(SDL_Renderer* renderer, const MeshDraw* draw, const Tri face) {
+	const Mesh* mesh = draw->mesh;
+	const ProjectedVertices* projected = &draw->projected;
+
+	const Material* material = meshMaterial(mesh, face.material);
+	const SDL_FColor diffuse = material ? material->diffuse : (SDL_FColor){1, 1, 1, 1};
+	const SDL_BlendMode blendMode = material ? material->blendMode : SDL_BLENDMODE_NONE;
+	const Texture* texture = faceTexture(material, face);
+	const TextureLevel* level = texture ? &texture->levels[faceTextureLevel(draw, face, texture)] : NULL;
+
+	float attrs[3 * CORNER_ATTRIBUTES] = {
+		draw->light[face.n0], 0, 0,
+		draw->light[face.n1], 0, 0,
+		draw->light[face.n2], 0, 0
+	};
+
+	if (texture) {
+		const int t[3] = { face.t0, face.t1, face.t2 };
+
+		// Texture rows go down but OBJ v goes up
+		for (int i=0; i<3; ++i) {
+			attrs[i * CORNER_ATTRIBUTES + 1] = (float)mesh->texcoords[t[i]].x;
+			attrs[i * CORNER_ATTRIBUTES + 2] = 1.0f - (float)mesh->texcoords[t[i]].y;
+		}
+	}
+
+	if ((projected->outcode[face.v0] | projected->outcode[face.v1] | projected->outcode[face.v2]) & CLIP_NEAR) {
+		submitClippedFace(renderer, draw, face, attrs, diffuse, level, blendMode);
+		return;
+	}
+
+	SDL_Vertex verts[3];
+	const int ids[3] = { face.v0, face.v1, face.v2 };
+
+	for (int i=0; i<3; ++i) {
+		const int v = ids[i];
+		const float* a = &attrs[i * CORNER_ATTRIBUTES];
+
+		verts[i] = (SDL_Vertex){ {projected->x[v], projected->y[v]}, shadeColor(a[0], diffuse), {a[1], a[2]} };
+	}
+
+	const float invW[3] = {
+		1.0f / projected->depth[face.v0],
+		1.0f / projected->depth[face.v1],
+		1.0f / projected->depth[face.v2]
+	};
+
+	submitTri(renderer, ids, level, blendMode, verts, invW);
+}
+
+// Whole mesh culling, projection and lighting. Returns false if the mesh is off screen, otherwise draw is ready
+// for drawFaces and its arrays stay valid until arena is reset
+bool prepareMesh(MeshDraw* draw, const Mesh* mesh, const Transform* transform, const CamProjectionInfo* camInfo,
+	const Frustum* frustum, Arena* arena) {
+	// Camera and model matrices are composed once, every vertex is then one multiply + divide
+	draw->mesh = mesh;
+	draw->model = mat4FromTransform(transform);
+	draw->mvp = mat4Mul(&camInfo->viewProjection, &draw->model);
+
+	// Whole mesh rejection before any per-vertex or per-face work, cheap sphere test first
+	cullStats.meshesTested++;
+	PROFILE_BEGIN(PROFILE_STAGE_CULL);
+
+	if (frustumCullSphere(frustum, transformSphere(mesh->boundingSphere, &draw->model))) {
+		cullStats.sphereCulled++;
+		PROFILE_END(PROFILE_STAGE_CULL);
+		return false;
+	}
+	if (clipCullAABB(&draw->mvp, &mesh->bounds)) {
+		cullStats.boxCulled++;
+		PROFILE_END(PROFILE_STAGE_CULL);
+		return false;
+	}
+
+	PROFILE_END(PROFILE_STAGE_CULL);
+
+	// Normals need the inverse transpose so non-uniform scale doesn't skew them
+	draw->normalMatrix = mat4Identity();
+	mat4 invModel;
+	const bool hasInverse = mat4Inverse(&draw->model, &invModel);
+	if (hasInverse) {
+		draw->normalMatrix = mat4Transpose(&invModel);
+	}
+
+	// Camera taken into object space once, so back faces are one plane test per face with nothing transformed.
+	// Same sign as the world space test since the plane normal goes through the inverse transpose
+	draw->objectSpaceCull = hasInverse && mesh->facePlanes;
+	draw->camObject = (v3){0, 0, 0};
+	if (draw->objectSpaceCull) {
+		const v4 c = mat4MulPoint(&invModel, camInfo->position);
+		draw->camObject = (v3){ c.x, c.y, c.z };
+	}
+
+	const v3 sunDir = normalize(sun);
+
+	PROFILE_BEGIN(PROFILE_STAGE_PROJECT);
+
+	allocProjectedVertices(&draw->projected, arena, mesh->vertexCount);
+
+	if (mesh->soa.count == mesh->vertexCount) {
+		projectSoA(&mesh->soa, &draw->mvp, SDL_WINDOW_WIDTH, SDL_WINDOW_HEIGHT, &draw->projected);
+	} else {
+		projectMeshVertices(mesh, &draw->mvp, &draw->projected);
+	}
+
+	// Lit once per normal, every corner using that normal (and the batch vertex it becomes) shares the result
+	draw->light = ARENA_ARRAY(arena, float, mesh->normalCount);
+
+	if (mesh->soa.normalCount == mesh->normalCount) {
+		lightSoA(&mesh->soa, &draw->normalMatrix, sunDir, AMBIENT_LIGHT, draw->light);
+	} else {
+		lightMeshNormals(mesh, &draw->normalMatrix, sunDir, draw->light);
+	}
+
+	PROFILE_END(PROFILE_STAGE_PROJECT);
+
+	return true;
+}
+
+// Back-face test for faces[i] of a prepared mesh, true when the camera sees its front
+static bool faceFacesCamera(const MeshDraw* draw, const int i, const CamProjectionInfo* camInfo) {
+	if (draw->objectSpaceCull) {
+		const v4 plane = draw->mesh->facePlanes[i];
+		const v3 cam = draw->camObject;
+
+		// Negative when the camera is behind the face
+		return plane.x * cam.x + plane.y * cam.y + plane.z * cam.z + plane.w >= 0;
+	}
+
+	// Fallback for a model matrix with no inverse, the face normal taken to world space instead
+	const Tri face = draw->mesh->faces[i];
+	const v4 worldV0 = mat4MulPoint(&draw->model, draw->mesh->vertices[face.v0]);
+	const v3 normal = mat4MulDir(&draw->normalMatrix, meshFaceNormal(draw->mesh, face));
+	const v3 viewDir = v3Sub((v3){worldV0.x, worldV0.y, worldV0.z}, camInfo->position);
+
+	return dotProduct(normal, viewDir) <= 0;
+}
+
+// Culls and submits faces[first .. first+count) of a prepared mesh, or the count face indices in faces when
+// it isn't NULL. byDepth submits them back to front, faceSort comes out of meshArena
+void drawFaces(SDL_Renderer* renderer, const MeshDraw* draw, const CamProjectionInfo* camInfo, const int* faces,
+	const int first, const int count, const bool byDepth) {
+	const Mesh* mesh = draw->mesh;
+	const ProjectedVertices* projected = &draw->projected;
+
+	if (byDepth) {
+		sortBegin(&faceSort, &meshArena, (size_t)count);
+	}
+
+	PROFILE_BEGIN(PROFILE_STAGE_FACES);
+	PROFILE_COUNT(PROFILE_COUNTER_FACES_TESTED, count);
+
+	for (int k=0; k<count; ++k) {
+		const int i = faces ? faces[k] : first + k;
+		const Tri face = mesh->faces[i];
+
+		// Every corner is outside the same frustum plane, so the whole face is
+		if (projected->outcode[face.v0] & projected->outcode[face.v1] & projected->outcode[face.v2]) {
+			PROFILE_COUNT(PROFILE_COUNTER_FACES_CULLED, 1);
+			continue;
+		}
+
+		if (!faceFacesCamera(draw, i, camInfo)) {
+			PROFILE_COUNT(PROFILE_COUNTER_FACES_CULLED, 1);
+			continue;
+		}
+
+		if (byDepth) {
+			// Sum of the corner depths orders the same as the centroid depth, inverted for back to front
+			const float depth = projected->depth[face.v0] + projected->depth[face.v1] + projected->depth[face.v2];
+
+			sortPush(&faceSort, ~floatSortKey(depth), i);
+			continue;
+		}
+
+		submitFace(renderer, draw, face);
+	}
+
+	PROFILE_END(PROFILE_STAGE_FACES);
+
+	if (byDepth) {
+		PROFILE_BEGIN(PROFILE_STAGE_SORT);
+		radixSort(&faceSort);
+		PROFILE_END(PROFILE_STAGE_SORT);
+
+		PROFILE_BEGIN(PROFILE_STAGE_SUBMIT);
+		for (size_t i=0; i<faceSort.count; ++i) {
+			const Uint32 f = faceSort.values[i];
+			submitFace(renderer, draw, mesh->faces[f]);
+		}
+		PROFILE_END(PROFILE_STAGE_SUBMIT);
+	}
+}
+
+// Draws a prepared mesh into the batch, faces back to front for painter's order
+void renderMesh(SDL_Renderer* renderer, const MeshDraw* draw, const CamProjectionInfo* camInfo) {
+	batchBeginMesh(&batch, &meshArena, draw->mesh->vertexCount);
+	drawFaces(renderer, draw, camInfo, NULL, 0, (int)draw->mesh->faceCount, true);
+
+	// Projection, vertex slot and sort buffers were all for this mesh only, its triangles stay in the open batch
+	arenaReset(&meshArena);
+}
+
+// ========== OCCLUSION ==========
+
+// Front faces of a prepared mesh into the occlusion buffer as one occluder. Faces crossing the camera plane and see through
+// materials are left out, which can only let more objects through
+void drawOccluder(const MeshDraw* draw, const CamProjectionInfo* camInfo) {
+	const Mesh* mesh = draw->mesh;
+	const ProjectedVertices* projected = &draw->projected;
+
+	occlusionBeginMesh(&occlusion);
+
+	for (int i=0; i<(int)mesh->faceCount; ++i) {
+		const Tri face = mesh->faces[i];
+		const Uint8 o0 = projected->outcode[face.v0], o1 = projected->outcode[face.v1], o2 = projected->outcode[face.v2];
+
+		if ((o0 & o1 & o2) || ((o0 | o1 | o2) & CLIP_NEAR)) continue;
+		if (!faceFacesCamera(draw, i, camInfo)) continue;
+
+		const Material* material = meshMaterial(mesh, face.material);
+		if (material && material->blendMode != SDL_BLENDMODE_NONE) continue;
+
+		const float x[3] = { projected->x[face.v0], projected->x[face.v1], projected->x[face.v2] };
+		const float y[3] = { projected->y[face.v0], projected->y[face.v1], projected->y[face.v2] };
+		const float invW[3] = {
+			1.0f / projected->depth[face.v0],
+			1.0f / projected->depth[face.v1],
+			1.0f / projected->depth[face.v2]
+		};
+
+		occlusionDrawTri(&occlusion, x, y, invW);
+	}
+
+	occlusionEndMesh(&occlusion);
+}
+
+// ========== DRAW STATE ORDER ==========
+
+// Packed so sorted keys group draws by blend mode, then texture, then mip level, then mesh. Blend mode is the
+// top bit so see through materials are drawn after the opaque geometry behind them. Every level is its own
+// SDL_Texture, so with the level in the key each one is bound once per frame. level is ignored when untextured
+static Uint32 drawStateKey(const Material* material, const bool textured, const int level, const int drawIndex) {
+	const Uint32 blend = material && material->blendMode != SDL_BLENDMODE_NONE ? 1 : 0;
+	const Uint32 texture = textured ? (Uint32)(material - materialLibrary.materials) + 1 : 0;
+	const Uint32 levelKey = textured ? (Uint32)level : 0;
+
+	return (blend << 31) |
+		((texture & ((1U << DRAW_KEY_TEXTURE_BITS) - 1)) << (DRAW_KEY_LEVEL_BITS + DRAW_KEY_MESH_BITS)) |
+		((levelKey & ((1U << DRAW_KEY_LEVEL_BITS) - 1)) << DRAW_KEY_MESH_BITS) |
+		((Uint32)drawIndex & ((1U << DRAW_KEY_MESH_BITS) - 1));
+}
+
+// Splits a textured range's faces by mip level (counting sort into frameArena) and adds one item per level
+// used. Faces without texture coordinates are drawn untextured so they get an item of their own
+static size_t pushLevelItems(DrawItem* items, size_t n, const MeshDraw* draw, const int d, const MeshFaceRange range,
+	const Material* material) {
+	const Mesh* mesh = draw->mesh;
+
+	// Bucket 0 is untextured, bucket l+1 is level l
+	int start[TEXTURE_MAX_LEVELS + 2] = {0};
+	Uint8* bucket = ARENA_ARRAY(&frameArena, Uint8, (size_t)range.count);
+	int* faces = ARENA_ARRAY(&frameArena, int, (size_t)range.count);
+
+	for (int k=0; k<range.count; ++k) {
+		const Tri face = mesh->faces[range.first + k];
+		const Texture* texture = faceTexture(material, face);
+
+		bucket[k] = (Uint8)(texture ? faceTextureLevel(draw, face, texture) + 1 : 0);
+		start[bucket[k] + 1]++;
+	}
+
+	for (int b=0; b<=TEXTURE_MAX_LEVELS; ++b) start[b + 1] += start[b];
+
+	int cursor[TEXTURE_MAX_LEVELS + 1];
+	memcpy(cursor, start, sizeof(cursor));
+
+	for (int k=0; k<range.count; ++k) {
+		faces[cursor[bucket[k]]++] = range.first + k;
+	}
+
+	for (int b=0; b<=TEXTURE_MAX_LEVELS; ++b) {
+		const int count = start[b + 1] - start[b];
+		if (count == 0) continue;
+
+		items[n] = (DrawItem){ d, { range.material, range.first, count }, faces + start[b] };
+		sortPush(&stateSort, drawStateKey(material, b > 0, b - 1, d), (Uint32)n++);
+	}
+
+	return n;
+}
+
+// Used whenever nothing needs painter's order (the rasterizer's z-buffer, or painter's sort turned off).
+// Every visible mesh is prepared up front into frameArena, then each material range (split by mip level when
+// textured) is drawn in drawStateKey order across the whole frame, so a texture level / blend mode is bound
+// once per frame rather than once per mesh
+void renderByState(SDL_Renderer* renderer, const MeshDraw* draws, const int drawCount, const CamProjectionInfo* camInfo) {
+	// Upper bound, a textured range can become an item per level plus one for faces without texture coordinates
+	size_t itemCount = 0;
+	for (int d=0; d<drawCount; ++d) {
+		const Mesh* mesh = draws[d].mesh;
+		if (mesh->faceRangeCount == 0) {
+			itemCount++;
+			continue;
+		}
+
+		for (int r=0; r<mesh->faceRangeCount; ++r) {
+			const Material* material = meshMaterial(mesh, mesh->faceRanges[r].material);
+			itemCount += material && material->diffuseMap ? TEXTURE_MAX_LEVELS + 1 : 1;
+		}
+	}
+
+	DrawItem* items = ARENA_ARRAY(&frameArena, DrawItem, itemCount);
+	sortBegin(&stateSort, &frameArena, itemCount);
+
+	size_t n = 0;
+	for (int d=0; d<drawCount; ++d) {
+		const Mesh* mesh = draws[d].mesh;
+
+		// Meshes built without ranges are drawn whole, as untextured
+		if (mesh->faceRangeCount == 0) {
+			items[n] = (DrawItem){ d, { -1, 0, (int)mesh->faceCount }, NULL };
+			sortPush(&stateSort, drawStateKey(NULL, false, 0, d), (Uint32)n++);
+			continue;
+		}
+
+		for (int r=0; r<mesh->faceRangeCount; ++r) {
+			const MeshFaceRange range = mesh->faceRanges[r];
+			const Material* material = meshMaterial(mesh, range.material);
+
+			if (material && material->diffuseMap) {
+				n = pushLevelItems(items, n, &draws[d], d, range, material);
+				continue;
+			}
+
+			items[n] = (DrawItem){ d, range, NULL };
+			sortPush(&stateSort, drawStateKey(material, false, 0, d), (Uint32)n++);
+		}
+	}
+
+	PROFILE_BEGIN(PROFILE_STAGE_SORT);
+	radixSort(&stateSort);
+	PROFILE_END(PROFILE_STAGE_SORT);
+
+	int current = -1;
+
+	for (size_t i=0; i<stateSort.count; ++i) {
+		const DrawItem item = items[stateSort.values[i]];
+
+		// Vertex slots (and the face sort) only last while the same mesh is being drawn
+		if (item.draw != current) {
+			arenaReset(&meshArena);
+			if (!softwareRaster) {
+				batchBeginMesh(&batch, &meshArena, draws[item.draw].mesh->vertexCount);
+			}
+			current = item.draw;
+		}
+
+		drawFaces(renderer, &draws[item.draw], camInfo, item.faces, item.range.first, item.range.count, false);
+	}
+
+	arenaReset(&meshArena);
+}
+
+// Frees the frame's scratch memory. Debug builds report any frame after the first that needed the heap,
+// which only happens while the arenas are still growing to fit the scene
+void endFrameArenas() {
+	arenaReset(&frameArena);
+
+#if ARENA_DEBUG
+	const Uint64 heapCalls = frameArena.heapCalls + meshArena.heapCalls;
+
+	if (frameNumber > 0 && heapCalls != arenaHeapCalls) {
+		printf("Frame %llu made %llu heap calls growing the arenas (high water : frame %zuKB, mesh %zuKB)\n",
+			(unsigned long long)frameNumber, (unsigned long long)(heapCalls - arenaHeapCalls),
+			frameArena.highWater / 1024, meshArena.highWater / 1024);
+	}
+
+	arenaHeapCalls = heapCalls;
+	frameNumber++;
+#endif
+}
+
+void render(SDL_Renderer* renderer, Scene* scene) {
 	// Clear screen
 	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
 	SDL_RenderClear(renderer);
 
-	SDL_FColor colf = {
-		0, 0, 0, 1
-	};
+	const CamProjectionInfo camInfo = getCamProjectionInfo(&cam);
+	const Frustum frustum = frustumFromMatrix(&camInfo.viewProjection);
 
-	v3 points[3];
-	v2 projectedPoints[3];
-	SDL_Vertex verts[3];
+	// Refit / rebuild then walk the BVH, only objects that may be on screen come back
+	PROFILE_BEGIN(PROFILE_STAGE_SCENE);
+	sceneUpdate(scene);
+	sceneQuery(scene, &frustum);
+
+	cullStats.objectsTotal += scene->objectCount;
+	cullStats.bvhCulled += scene->objectCount - scene->visibleCount;
+
+	if (softwareRaster) {
+		rasterBegin(rasterizer, &frameArena);
+	} else {
+		batchBegin(&batch, &frameArena);
+	}
+
+	// Painter's order between objects as well as inside them, otherwise draw order comes from the material ranges
+	const bool painterOrder = painterSort && !softwareRaster;
+
+	sortBegin(&objectSort, &frameArena, scene->visibleCount);
+
+	for (int i=0; i<scene->visibleCount; ++i) {
+		const AABB* b = &scene->objects[scene->visible[i]].worldBounds;
+		const v3 center = v3Scale(v3Add(b->min, b->max), 0.5);
+		const float depth = (float)dotProduct(v3Sub(center, camInfo.position), camInfo.normalV);
+
+		sortPush(&objectSort, painterOrder ? ~floatSortKey(depth) : 0, scene->visible[i]);
+	}
+
+	radixSort(&objectSort);
+	PROFILE_END(PROFILE_STAGE_SCENE);
 
-	for (int i=0; i<mesh.faceCount; ++i) {
-		//v3 normal = mesh.normals[mesh.faces[i].n0];
+	// Pixels per world unit at depth 1
+	const double pixelScale = camInfo.projection.m[0][0] * SDL_WINDOW_WIDTH * 0.5;
 
-		v3 viewDir = normalize(v3Sub(mesh.vertices[mesh.faces[i].v0], cam.position));
+	// State counting starts again each frame, so the first bind of the frame counts
+	drawStateBound = false;
 
-		if (dotProduct(mesh.normals[mesh.faces[i].n0], viewDir) > 0) {
-			continue; // Skip if facing away from cam
+	const Mesh** objectMeshes = ARENA_ARRAY(&frameArena, const Mesh*, objectSort.count);
+	sortBegin(&occluderSort, &frameArena, objectSort.count);
+
+	for (size_t i=0; i<objectSort.count; ++i) {
+		SceneObject* object = &scene->objects[objectSort.values[i]];
+
+		// Level of detail from the projected radius of the object's world bounds
+		const AABB* b = &object->worldBounds;
+		const v3 center = v3Scale(v3Add(b->min, b->max), 0.5);
+		const double radius = v3Len(v3Sub(b->max, center));
+		const double depth = dotProduct(v3Sub(center, camInfo.position), camInfo.normalV);
+
+		// Camera inside or right up against the bounds always gets the full mesh
+		const double screenRadius = depth > radius ? radius * pixelScale / depth : INFINITY;
+
+		if (useLods && object->mesh->lodCount > 0) {
+			object->lod = selectMeshLOD(object->mesh, object->lod, screenRadius);
+		} else {
+			object->lod = 0;
 		}
 
-		// points[0] = transformV3(&mesh.vertices[mesh.faces[i].v0], &meshTrans);
-		// points[1] = transformV3(&mesh.vertices[mesh.faces[i].v1], &meshTrans);
-		// points[2] = transformV3(&mesh.vertices[mesh.faces[i].v2], &meshTrans);
+		objectMeshes[i] = getMeshLOD(object->mesh, object->lod);
+
+		// Biggest on screen first, those hide the most
+		if (screenRadius >= OCCLUDER_MIN_RADIUS) {
+			sortPush(&occluderSort, ~floatSortKey((float)screenRadius), (Uint32)i);
+		}
+	}
 
-		points[0] = mesh.vertices[mesh.faces[i].v0];
-		points[1] = mesh.vertices[mesh.faces[i].v1];
-		points[2] = mesh.vertices[mesh.faces[i].v2];
+	// Occluders are prepared (and drawn normally) first, objectDraws keeps them so it's only done once.
+	// Only worth it with something left to hide
+	MeshDraw** objectDraws = ARENA_ARRAY(&frameArena, MeshDraw*, objectSort.count);
+	bool* prepared = ARENA_ARRAY(&frameArena, bool, objectSort.count);
+	memset(prepared, 0, objectSort.count * sizeof(bool));
 
-		// colf.r = (( (unsigned int)((i%255)*23.324234543) )%255)/255.0;
-		// colf.g = (( (unsigned int)((i%255)*14.932543) )%255)/255.0;
-		// colf.b = (( (unsigned int)((i%255)*3.24234) )%255)/255.0;
+	const bool occlude = occlusionCulling && objectSort.count > 1 && occluderSort.count > 0;
 
-		double intensity = dotProduct(mesh.normals[mesh.faces[i].n0], viewDir);
+	if (occlude) {
+		PROFILE_BEGIN(PROFILE_STAGE_OCCLUSION);
+		occlusionBegin(&occlusion, SDL_WINDOW_WIDTH, SDL_WINDOW_HEIGHT);
+		radixSort(&occluderSort);
+
+		for (size_t k=0; k<occluderSort.count && k<MAX_OCCLUDERS; ++k) {
+			const Uint32 i = occluderSort.values[k];
+			const SceneObject* object = &scene->objects[objectSort.values[i]];
+
+			MeshDraw* draw = ARENA_ARRAY(&frameArena, MeshDraw, 1);
+			objectDraws[i] = prepareMesh(draw, objectMeshes[i], &object->transform, &camInfo, &frustum, &frameArena) ? draw : NULL;
+			prepared[i] = true;
+
+			if (objectDraws[i]) {
+				drawOccluder(objectDraws[i], &camInfo);
+			}
+		}
+		PROFILE_END(PROFILE_STAGE_OCCLUSION);
+	}
 
-		intensity *= -1;
+	MeshDraw* draws = painterOrder ? NULL : ARENA_ARRAY(&frameArena, MeshDraw, objectSort.count);
+	int drawCount = 0;
 
-		if (intensity < 0.0)
-			intensity = 0.0;
-		if (intensity > 1.0)
-			intensity = 1.0;
+	for (size_t i=0; i<objectSort.count; ++i) {
+		const SceneObject* object = &scene->objects[objectSort.values[i]];
 
-		colf.r = intensity;
-		colf.g = intensity;
-		colf.b = intensity;
+		// Hidden objects stop at one bounds test, before any projection
+		if (occlude && !prepared[i]) {
+			PROFILE_BEGIN(PROFILE_STAGE_OCCLUSION);
+			const bool hidden = occlusionTestAABB(&occlusion, &camInfo.viewProjection, &object->worldBounds);
+			PROFILE_END(PROFILE_STAGE_OCCLUSION);
 
-		projectPoints3DtoScreen(points, projectedPoints, 3, &cam);
+			if (hidden) {
+				cullStats.occluded++;
+				PROFILE_COUNT(PROFILE_COUNTER_OCCLUDED, 1);
+				continue;
+			}
+		}
+
+		MeshDraw local;
+		const MeshDraw* draw = prepared[i] ? objectDraws[i] : NULL;
+
+		if (!prepared[i]) {
+			// Painter's order draws each mesh as it goes so it only needs meshArena
+			Arena* arena = painterOrder ? &meshArena : &frameArena;
+			draw = prepareMesh(&local, objectMeshes[i], &object->transform, &camInfo, &frustum, arena) ? &local : NULL;
+		}
+		if (!draw) continue;
+
+		if (painterOrder) {
+			renderMesh(renderer, draw, &camInfo);
+		} else {
+			draws[drawCount++] = *draw;
+		}
+	}
+
+	if (!painterOrder) {
+		renderByState(renderer, draws, drawCount, &camInfo);
+	}
+
+	// Whatever is left of the frame's triangles (every mesh and instance shares the batch)
+	if (!softwareRaster) {
+		batchFlush(&batch, renderer);
+	}
 
-		// Triangle 1 (0,1,2)
-		verts[0] = (SDL_Vertex){ {projectedPoints[0].x, projectedPoints[0].y}, colf };
-		verts[1] = (SDL_Vertex){ {projectedPoints[1].x, projectedPoints[1].y}, colf };
-		verts[2] = (SDL_Vertex){ {projectedPoints[2].x, projectedPoints[2].y}, colf };
+	if (softwareRaster) {
+		PROFILE_BEGIN(PROFILE_STAGE_RASTER);
+		rasterFlush(rasterizer, renderer);
+		PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS, 1);
+		PROFILE_END(PROFILE_STAGE_RASTER);
+	}
 
-		SDL_RenderGeometry(renderer, NULL, verts, 3, NULL, 0);
+	// Read back before the overlay so it never ends up in a captured image
+	if (captureNextFrame) {
+		capturedFrame = SDL_RenderReadPixels(renderer, NULL);
+		captureNextFrame = false;
 	}
+
+	PROFILE_DRAW_OVERLAY(renderer);
+
+	PROFILE_BEGIN(PROFILE_STAGE_PRESENT);
 	SDL_RenderPresent(renderer);
+	PROFILE_END(PROFILE_STAGE_PRESENT);
+
+	endFrameArenas();
+}
+
+
+// ===== FRAME CAPTURE =====
+
+// Renders CAPTURE_VIEWS fixed points of the bench path (same views every run, so any renderer change shows up
+// as a pixel difference). --capture writes them as references, --compare checks them and writes a diff image
+// next to each failing reference. Returns false if anything failed or didn't match
+bool runCapture(SDL_Renderer* renderer, Scene* scene, const AABB* sceneBounds, const BenchOptions* options) {
+	const bool compare = options->compareDir != NULL;
+	const char* dir = compare ? options->compareDir : options->captureDir;
+
+	if (!compare && !SDL_CreateDirectory(dir)) {
+		printf("Error creating capture directory '%s' : %s\n", dir, SDL_GetError());
+		return false;
+	}
+
+	bool passed = true;
+	char path[1024];
+	char diffPath[1024];
+
+	for (int view=0; view<CAPTURE_VIEWS; ++view) {
+		benchPath(view, CAPTURE_VIEWS, sceneBounds);
+		applyMeshTrans(scene);
+
+		captureNextFrame = true;
+		render(renderer, scene);
+
+		if (!capturedFrame) {
+			printf("View %i : error reading back the frame : %s\n", view, SDL_GetError());
+			passed = false;
+			continue;
+		}
+
+		snprintf(path, sizeof(path), "%s/view_%02i.ppm", dir, view);
+
+		if (!compare) {
+			if (writePPM(path, capturedFrame)) {
+				printf("View %i : wrote '%s'\n", view, path);
+			} else {
+				passed = false;
+			}
+		} else {
+			SDL_Surface* reference = readPPM(path);
+			SDL_Surface* diffImage = NULL;
+			ImageDiff diff;
+
+			if (!reference || !compareImages(reference, capturedFrame, options->tolerance, &diff, &diffImage)) {
+				passed = false;
+			} else {
+				const double mismatch = 100.0 * diff.mismatched / diff.pixelCount;
+				const bool ok = mismatch <= options->maxMismatch;
+
+				printf("View %i : %s, %i pixels (%.3f%%) outside tolerance %i, max delta %i, mean delta %.3f\n",
+					view, ok ? "match" : "MISMATCH", diff.mismatched, mismatch, options->tolerance, diff.maxDelta, diff.meanDelta);
+
+				if (!ok) {
+					snprintf(diffPath, sizeof(diffPath), "%s/view_%02i.diff.ppm", dir, view);
+					if (writePPM(diffPath, diffImage)) printf("         diff written to '%s'\n", diffPath);
+					passed = false;
+				}
+			}
+
+			SDL_DestroySurface(reference);
+			SDL_DestroySurface(diffImage);
+		}
+
+		SDL_DestroySurface(capturedFrame);
+		capturedFrame = NULL;
+	}
+
+	if (compare) {
+		printf("Compare against '%s' %s\n", dir, passed ? "passed" : "FAILED");
+	}
+
+	return passed;
 }
 
+// Sizes and distances for --occlusion-check, in world units along the camera's view direction
+#define OCCLUSION_CHECK_RADIUS		4.0
+#define OCCLUSION_CHECK_DISTANCE	10.0
+#define OCCLUSION_CHECK_BOX_DEPTH	30.0
+
+// The mesh scaled to a big occluder in front of the camera. A box straight behind it must be hidden, boxes
+// in front of it or off to the side past its silhouette must not be
+bool runOcclusionCheck(const Mesh* mesh) {
+	const CamState checkCam = { {0, 0, 0}, {0, 0, 0}, cam.defNormal, cam.defUp };
+	const CamProjectionInfo camInfo = getCamProjectionInfo(&checkCam);
+	const Frustum frustum = frustumFromMatrix(&camInfo.viewProjection);
+
+	const Sphere bounds = mesh->boundingSphere;
+	const double scale = bounds.radius > 0 ? OCCLUSION_CHECK_RADIUS / bounds.radius : 1.0;
+	const v3 target = v3Scale(camInfo.normalV, OCCLUSION_CHECK_DISTANCE);
+
+	// Bounds centre moved onto the view axis
+	const Transform transform = { v3Sub(target, v3Scale(bounds.center, scale)), {0, 0, 0}, {scale, scale, scale} };
+
+	occlusionBegin(&occlusion, SDL_WINDOW_WIDTH, SDL_WINDOW_HEIGHT);
+
+	MeshDraw draw;
+	if (!prepareMesh(&draw, mesh, &transform, &camInfo, &frustum, &frameArena)) {
+		puts("Occlusion check : occluder culled");
+		arenaReset(&frameArena);
+		return false;
+	}
+	drawOccluder(&draw, &camInfo);
+	arenaReset(&frameArena);
+
+	int covered = 0;
+	for (int i=0; i<OCCLUSION_WIDTH * OCCLUSION_HEIGHT; ++i) {
+		if (occlusion.invW[i] > 0) covered++;
+	}
+
+	const struct {
+		const char* name;
+		v3 center;
+		double halfSize;
+		bool hidden;
+	} boxes[] = {
+		{ "behind", v3Scale(camInfo.normalV, OCCLUSION_CHECK_BOX_DEPTH), 1.0, true },
+		{ "in front", v3Scale(camInfo.normalV, OCCLUSION_CHECK_DISTANCE - OCCLUSION_CHECK_RADIUS - 2.0), 0.5, false },
+		{ "beside", v3Add(v3Scale(camInfo.normalV, OCCLUSION_CHECK_BOX_DEPTH), v3Scale(camInfo.rightV, OCCLUSION_CHECK_BOX_DEPTH * 0.8)), 1.0, false }
+	};
+
+	printf("Occlusion check : %zu faces, %i of %i occlusion pixels covered\n", mesh->faceCount, covered, OCCLUSION_WIDTH * OCCLUSION_HEIGHT);
+
+	bool passed = true;
+	for (size_t i=0; i<sizeof(boxes) / sizeof(boxes[0]); ++i) {
+		const v3 half = { boxes[i].halfSize, boxes[i].halfSize, boxes[i].halfSize };
+		const AABB box = { v3Sub(boxes[i].center, half), v3Add(boxes[i].center, half) };
+
+		const bool hidden = occlusionTestAABB(&occlusion, &camInfo.viewProjection, &box);
+		const bool ok = hidden == boxes[i].hidden;
+
+		printf("  box %-8s : %s (%s)\n", boxes[i].name, hidden ? "hidden" : "visible", ok ? "ok" : "WRONG");
+		passed = passed && ok;
+	}
+
+	printf("Occlusion check %s\n", passed ? "passed" : "FAILED");
+	return passed;
+}
 
 // HANDLE INPUTS
 
@@ -366,6 +1247,40 @@ void manageKeyDownEvent(const SDL_KeyboardEvent *e) {
 			if (kDown) break;
 			kDown=true;
 			break;
+
+		case SDLK_P:
+			if (pDown) break;
+			painterSort = !painterSort;
+			printf("Painter's sort %s\n", painterSort ? "on" : "off");
+			pDown=true;
+			break;
+
+		case SDLK_R:
+			if (rDown) break;
+			softwareRaster = !softwareRaster;
+			printf("Software rasterizer %s\n", softwareRaster ? "on" : "off");
+			rDown=true;
+			break;
+
+		case SDLK_L:
+			if (lDown) break;
+			useLods = !useLods;
+			printf("LODs %s\n", useLods ? "on" : "off");
+			lDown=true;
+			break;
+
+		case SDLK_C:
+			if (cDown) break;
+			occlusionCulling = !occlusionCulling;
+			printf("Occlusion culling %s\n", occlusionCulling ? "on" : "off");
+			cDown=true;
+			break;
+
+		case SDLK_O:
+			if (oDown) break;
+			PROFILE_TOGGLE_OVERLAY();
+			oDown=true;
+			break;
 		default:
 			//printf("KeyDown\n");
 			break;
@@ -426,6 +1341,31 @@ void manageKeyUpEvent(const SDL_KeyboardEvent *e) {
 			if (!kDown) break;
 			kDown=false;
 			break;
+
+		case SDLK_P:
+			if (!pDown) break;
+			pDown=false;
+			break;
+
+		case SDLK_R:
+			if (!rDown) break;
+			rDown=false;
+			break;
+
+		case SDLK_L:
+			if (!lDown) break;
+			lDown=false;
+			break;
+
+		case SDLK_C:
+			if (!cDown) break;
+			cDown=false;
+			break;
+
+		case SDLK_O:
+			if (!oDown) break;
+			oDown=false;
+			break;
 		default:
 			//printf("KeyUp\n");
 			break;
@@ -448,27 +1388,87 @@ void manageMouseMotion(const SDL_MouseMotionEvent *e) {
 	}
 }
 
+void handleEvent(const SDL_Event* e) {
+	switch (e->type) {
+		case SDL_EVENT_QUIT:
+			quitGame();
+			break;
+		case SDL_EVENT_KEY_DOWN:
+			manageKeyDownEvent(&e->key);
+			redrawRequested = true; // render option toggles
+			break;
+		case SDL_EVENT_KEY_UP:
+			manageKeyUpEvent(&e->key);
+			break;
+		case SDL_EVENT_MOUSE_MOTION:
+			manageMouseMotion(&e->motion);
+			break;
+		case SDL_EVENT_WINDOW_RESIZED:
+		case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+		case SDL_EVENT_WINDOW_EXPOSED:
+		case SDL_EVENT_WINDOW_RESTORED:
+			redrawRequested = true;
+			break;
+		default:
+			//printf("Event\n");
+			break;
+	}
+}
+
 
 
-int main(void) {
+int main(int argc, char* argv[]) {
 	printf("Hello, World!\n");
 
+	BenchOptions bench;
+	if (!parseBenchArgs(argc, argv, &bench)) {
+		return 1;
+	}
+
+	// Benchmarks run without a display or GPU, offscreen first then dummy
+	if (bench.enabled) {
+		SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+	}
+
 	Window window = createWindow(SDL_WINDOW_WIDTH, SDL_WINDOW_HEIGHT);
 
 	if (!SDL_Init(SDL_INIT_VIDEO)) {
-		SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
-		return SDL_APP_FAILURE;
+		if (bench.enabled) {
+			SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "dummy");
+		}
+
+		if (!bench.enabled || !SDL_Init(SDL_INIT_VIDEO)) {
+			SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
+			return SDL_APP_FAILURE;
+		}
 	}
 
 	initWindow(window);
-	SDL_Renderer* renderer = SDL_CreateRenderer(window->window, NULL);
+	SDL_Renderer* renderer = SDL_CreateRenderer(window->window, bench.enabled ? SDL_SOFTWARE_RENDERER : NULL);
 
 	if (!renderer) {
 		SDL_Log("Failed to create renderer: %s", SDL_GetError());
+
+		if (bench.enabled) {
+			return SDL_APP_FAILURE;
+		}
 	}
 
-	//Lock mouse to screen center
-	SDL_SetWindowRelativeMouseMode(window->window, true);
+	if (bench.enabled) {
+		softwareRaster = bench.softwareRaster;
+		painterSort = !bench.unsorted;
+		occlusionCulling = !bench.noOcclusion;
+		if (bench.occlusionCheck) {
+			printf("Occlusion check : '%s' on the %s video driver\n", bench.meshFile, SDL_GetCurrentVideoDriver());
+		} else if (bench.captureDir || bench.compareDir) {
+			printf("Capture mode : '%s', %i views on the %s video driver\n", bench.meshFile, CAPTURE_VIEWS, SDL_GetCurrentVideoDriver());
+		} else {
+			printf("Bench mode : '%s' for %i frames on the %s video driver\n", bench.meshFile, bench.frames, SDL_GetCurrentVideoDriver());
+		}
+	} else {
+		//Lock mouse to screen center
+		SDL_SetWindowRelativeMouseMode(window->window, true);
+	}
 
 	Uint64 now = SDL_GetPerformanceCounter();
 	Uint64 last = 0;
@@ -479,55 +1479,234 @@ int main(void) {
 
 	SDL_Event e;
 
-	int meshCount;
-	Mesh* meshes = loadMeshFromOBJ("cat.obj", &meshCount);
+	initArena(&frameArena, "frame", FRAME_ARENA_SIZE);
+	initArena(&meshArena, "mesh", MESH_ARENA_SIZE);
+	rasterizer = createRasterizer(renderer, SDL_WINDOW_WIDTH, SDL_WINDOW_HEIGHT, SDL_GetNumLogicalCPUCores());
+
+	int meshCount = 0;
+	Mesh* meshes = loadMeshFromOBJ(bench.enabled ? bench.meshFile : "cat.obj", &meshCount);
+
+	if (bench.enabled && !meshes) {
+		printf("Bench mesh '%s' failed to load\n", bench.meshFile);
+		return 1;
+	}
+
+	// Simplified levels, then the float mirror for the SIMD projection kernels and the culling planes on every level
+	for (int i=0; i<meshCount; ++i) {
+		buildMeshLODs(&meshes[i]);
+		buildMeshSoA(&meshes[i]);
+		buildMeshFacePlanes(&meshes[i]);
+
+		for (int l=0; l<meshes[i].lodCount; ++l) {
+			buildMeshSoA(&meshes[i].lods[l]);
+			buildMeshFacePlanes(&meshes[i].lods[l]);
+		}
+	}
+
+	// Every object in a file shares its mtllib, textures get their mip chains as they load
+	if (meshCount > 0 && meshes[0].materialLibrary[0] != '\0') {
+		loadMaterialLibrary(&materialLibrary, renderer, meshes[0].materialLibrary);
+	}
+	for (int i=0; i<meshCount; ++i) {
+		bindMeshMaterials(&meshes[i], &materialLibrary);
+	}
+
+	// Scene takes ownership of the meshes, one object each
+	Scene scene = newScene();
+	sceneAddMeshes(&scene, meshes, meshCount);
+
+	// --instances N : square grid of N more copies of the first mesh, all sharing its data
+	if (bench.instances > 0 && meshCount > 0) {
+		const int side = (int)ceil(sqrt(bench.instances + 1.0));
+		const double spacing = 2.5 * fmax(meshes[0].boundingSphere.radius, 0.5);
+
+		Transform* transforms = malloc(bench.instances * sizeof(Transform));
+		objectOffsets = calloc(scene.objectCount + bench.instances, sizeof(v3));
+
+		if (!transforms || !objectOffsets) {
+			puts("Error allocating instances");
+			raise(SIGTERM);
+		}
+
+		// Cell 0 is the original object
+		for (int i=0; i<bench.instances; ++i) {
+			const int cell = i + 1;
+			const v3 offset = { (cell % side) * spacing, (cell / side) * spacing, 0 };
+
+			transforms[i] = (Transform){ offset, {0,0,0}, {1,1,1} };
+			objectOffsets[scene.objectCount + i] = offset;
+		}
+
+		sceneAddInstances(&scene, &meshes[0], transforms, bench.instances);
+		free(transforms);
+
+		printf("Added %i instances of the first mesh (%zu faces each)\n", bench.instances, meshes[0].faceCount);
+	}
+
+	Transform lastMeshTrans = meshTrans;
+
+	// Whole scene bounds for the bench camera path
+	AABB sceneBounds = {0};
+	for (int i=0; i<scene.objectCount; ++i) {
+		const AABB* b = &scene.objects[i].worldBounds;
+
+		if (i == 0) {
+			sceneBounds = *b;
+			continue;
+		}
+
+		sceneBounds.min = (v3){ fmin(sceneBounds.min.x, b->min.x), fmin(sceneBounds.min.y, b->min.y), fmin(sceneBounds.min.z, b->min.z) };
+		sceneBounds.max = (v3){ fmax(sceneBounds.max.x, b->max.x), fmax(sceneBounds.max.y, b->max.y), fmax(sceneBounds.max.z, b->max.z) };
+	}
+
+	BenchTimings benchTimings = {0};
+	int benchFrame = 0;
+
+	int exitCode = 0;
+	const bool capturing = bench.captureDir || bench.compareDir;
+	const bool checking = capturing || bench.occlusionCheck;
+
+	// Capture / compare draws its fixed views and skips the timed loop
+	if (capturing) {
+		if (!runCapture(renderer, &scene, &sceneBounds, &bench)) {
+			exitCode = 1;
+		}
+		gameRunning = false;
+	}
+
+	if (bench.occlusionCheck) {
+		if (meshCount == 0 || !runOcclusionCheck(&meshes[0])) {
+			exitCode = 1;
+		}
+		gameRunning = false;
+	}
+
+	// Redraw-on-change and the fps limiter are for the interactive window, bench mode times every frame
+	const bool redrawOnChange = REDRAW_ON_CHANGE && !bench.enabled;
+	const Uint64 framePeriodNS = (bench.targetFps > 0 && !bench.enabled) ? SDL_NS_PER_SECOND / bench.targetFps : 0;
+	Uint64 nextFrameNS = SDL_GetTicksNS();
+
+	CamState lastDrawnCam = cam;
+	bool idle = false;
 
 	while (gameRunning) {
+		// Nothing changed last time round, block until something happens instead of spinning
+		if (idle) {
+			if (SDL_WaitEventTimeout(&e, IDLE_WAIT_MS)) {
+				handleEvent(&e);
+			}
+
+			// Time spent asleep isn't simulated, held keys start moving from here
+			now = SDL_GetPerformanceCounter();
+			nextFrameNS = SDL_GetTicksNS();
+		}
+
 		// Update deltaTime
 		last = now;
 		now = SDL_GetPerformanceCounter();
 		deltaTime = (double)(now - last) / (double)SDL_GetPerformanceFrequency();
+		PROFILE_BEGIN(PROFILE_STAGE_FRAME);
+
+		// Fixed step along the scripted path, warmup frames go round it as well
+		if (bench.enabled) {
+			deltaTime = BENCH_FRAME_DELTA;
+			benchPath(benchFrame, BENCH_WARMUP_FRAMES + bench.frames, &sceneBounds);
+		}
 
-		// FPS
+		// FPS (bench mode reports its own timings instead), counts rendered frames and only runs while awake
 		timeAccum += deltaTime;
-		frames++;
-		if (timeAccum > 1) {
+		if (timeAccum > 1 && !bench.enabled) {
 			timeAccum -= 1;
-			printf("%ifps\n", frames);
+			printf("%ifps (objects culled %i/%i : bvh %i, sphere %i, box %i, occluded %i)\n", (int)frames,
+				cullStats.bvhCulled + cullStats.sphereCulled + cullStats.boxCulled + cullStats.occluded, cullStats.objectsTotal,
+				cullStats.bvhCulled, cullStats.sphereCulled, cullStats.boxCulled, cullStats.occluded);
+			PROFILE_PRINT();
+			cullStats = (CullStats){0};
 			frames = 0;
 		}
 
 		// Event handler
 		while (SDL_PollEvent(&e)) {
-			switch (e.type) {
-				case SDL_EVENT_QUIT:
-					quitGame();
-					break;
-				case SDL_EVENT_KEY_DOWN:
-					manageKeyDownEvent(&e.key);
-					break;
-				case SDL_EVENT_KEY_UP:
-					manageKeyUpEvent(&e.key);
-					break;
-				case SDL_EVENT_MOUSE_MOTION:
-					manageMouseMotion(&e.motion);
-					break;
-				default:
-					//printf("Event\n");
-					break;
-			}
+			handleEvent(&e);
 		}
 
+		PROFILE_BEGIN(PROFILE_STAGE_UPDATE);
 		update(deltaTime);
-		render(renderer, meshes[0]);
+		// The BVH is refitted on the next render
+		if (memcmp(&meshTrans, &lastMeshTrans, sizeof(Transform)) != 0) {
+			applyMeshTrans(&scene);
+			lastMeshTrans = meshTrans;
+		}
+		PROFILE_END(PROFILE_STAGE_UPDATE);
+
+		// Camera moved, an object moved or was added, or an event asked for it
+		const bool dirty = redrawRequested || scene.needsRebuild || scene.needsRefit ||
+			memcmp(&cam, &lastDrawnCam, sizeof(CamState)) != 0;
+
+		if (!redrawOnChange || dirty) {
+			render(renderer, &scene);
+
+			lastDrawnCam = cam;
+			redrawRequested = false;
+			idle = false;
+			frames++;
+
+			PROFILE_END(PROFILE_STAGE_FRAME);
+			PROFILE_END_FRAME();
+		} else {
+			idle = true;
+		}
+
+		// Frame limiter, sleeps off what's left of the frame period (SDL_DelayPrecise spins the last bit)
+		if (framePeriodNS > 0 && !idle) {
+			const Uint64 nowNS = SDL_GetTicksNS();
+
+			nextFrameNS += framePeriodNS;
+			if (nextFrameNS < nowNS) {
+				// Fell behind, don't try to catch up with a burst of frames
+				nextFrameNS = nowNS;
+			} else {
+				SDL_DelayPrecise(nextFrameNS - nowNS);
+			}
+		}
+
+		if (bench.enabled) {
+			// Whole frame : event poll, update, scene refit and render + present
+			const double ms = (double)(SDL_GetPerformanceCounter() - now) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+			if (benchFrame >= BENCH_WARMUP_FRAMES) {
+				benchRecordFrame(&benchTimings, ms);
+			}
+
+			if (++benchFrame >= BENCH_WARMUP_FRAMES + bench.frames) {
+				gameRunning = false;
+			}
+		}
+	}
+
+	if (bench.enabled && !checking) {
+		const char* rendererName = renderer ? SDL_GetRendererName(renderer) : "none";
+
+		if (!writeBenchReport(&bench, &benchTimings, rendererName)) {
+			exitCode = 1;
+		}
+		// Per-stage breakdown of the last PROFILE_HISTORY frames
+		PROFILE_PRINT();
+		freeBenchTimings(&benchTimings);
 	}
 
 	// Cleanup
-	freeMesh(&meshes[0]);
+	freeScene(&scene);
+	freeMaterialLibrary(&materialLibrary);
+	free(objectOffsets);
+	printf("Arena high water : frame %zuKB, mesh %zuKB\n", frameArena.highWater / 1024, meshArena.highWater / 1024);
+	freeArena(&frameArena);
+	freeArena(&meshArena);
+	destroyRasterizer(rasterizer);
 
 	SDL_DestroyRenderer(renderer);
 	destroyWindow(window);
 	SDL_Quit();
 
-	return 0;
+	return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+// .mtl material libraries
+// Created by James Schaffer on 16/10/2026.
+
+#include "material.h"
+#include "objparse.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Keyword at the start of a line followed by a blank
+static const char* matchKeyword(const char* p, const char* keyword) {
+	const size_t length = strlen(keyword);
+
+	if (strncmp(p, keyword, length) != 0) return NULL;
+	if (p[length] != ' ' && p[length] != '\t') return NULL;
+
+	return p + length;
+}
+
+// map_Kd can have options (-s 1 1 1 ...) before the file name, which is always the last word
+static void lastWord(char* name) {
+	char* word = name;
+
+	for (char* c = name; *c; ++c) {
+		if ((c[0] == ' ' || c[0] == '\t') && c[1] != ' ' && c[1] != '\t' && c[1] != '\0') word = c + 1;
+	}
+
+	if (word != name) memmove(name, word, strlen(word) + 1);
+}
+
+// ========== LOADING ==========
+
+bool loadMaterialLibrary(MaterialLibrary* lib, SDL_Renderer* renderer, const char* fileName) {
+	*lib = (MaterialLibrary){0};
+
+	char path[512];
+	snprintf(path, sizeof(path), "%s%s", RESOURCES_TEXTURES_DIR, fileName);
+
+	size_t length;
+	char* text = readWholeFile(path, &length);
+	if (!text) {
+		printf("Error opening material library '%s'\n", path);
+		return false;
+	}
+
+	int capacity = 0;
+	Material* current = NULL;
+
+	for (const char* p = text; *p; ) {
+		while (*p == ' ' || *p == '\t') p++;
+
+		const char* args;
+
+		if ((args = matchKeyword(p, "newmtl"))) {
+			if (lib->count == capacity) {
+				capacity = capacity ? capacity * 2 : 8;
+				lib->materials = realloc(lib->materials, (size_t)capacity * sizeof(Material));
+				if (!lib->materials) {
+					puts("Error allocating materials");
+					raise(SIGTERM);
+				}
+			}
+
+			current = &lib->materials[lib->count++];
+			*current = (Material){ .diffuse = {1, 1, 1, 1}, .blendMode = SDL_BLENDMODE_NONE };
+			parseName(args, current->name, sizeof(current->name));
+		} else if (current && (args = matchKeyword(p, "Kd"))) {
+			double rgb[3];
+			if ((args = parseDouble(args, &rgb[0])) && (args = parseDouble(args, &rgb[1])) && parseDouble(args, &rgb[2])) {
+				current->diffuse = (SDL_FColor){ (float)rgb[0], (float)rgb[1], (float)rgb[2], current->diffuse.a };
+			}
+		} else if (current && ((args = matchKeyword(p, "d")) || (args = matchKeyword(p, "Tr")))) {
+			double opacity;
+			if (parseDouble(args, &opacity)) {
+				// Tr is the inverse of d
+				if (p[0] == 'T') opacity = 1.0 - opacity;
+
+				current->diffuse.a = (float)SDL_clamp(opacity, 0.0, 1.0);
+				current->blendMode = current->diffuse.a < 1.0f ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE;
+			}
+		} else if (current && (args = matchKeyword(p, "map_Kd"))) {
+			char map[MESH_MATERIAL_NAME_MAX];
+			parseName(args, map, sizeof(map));
+			lastWord(map);
+
+			char mapPath[512];
+			snprintf(mapPath, sizeof(mapPath), "%s%s", RESOURCES_TEXTURES_DIR, map);
+
+			freeTexture(current->diffuseMap);
+			current->diffuseMap = loadTexture(renderer, mapPath);
+		}
+
+		// Everything else (specular, transparency, illum ...) isn't drawn
+		const char* lineEnd = strchr(p, '\n');
+		if (!lineEnd) break;
+		p = lineEnd + 1;
+	}
+
+	free(text);
+	return true;
+}
+
+void freeMaterialLibrary(MaterialLibrary* lib) {
+	for (int i=0; i<lib->count; ++i) {
+		freeTexture(lib->materials[i].diffuseMap);
+	}
+	free(lib->materials);
+
+	*lib = (MaterialLibrary){0};
+}
+
+const Material* findMaterial(const MaterialLibrary* lib, const char* name) {
+	for (int i=0; i<lib->count; ++i) {
+		if (strcmp(lib->materials[i].name, name) == 0) return &lib->materials[i];
+	}
+	return NULL;
+}
+
+// ========== BINDING ==========
+
+static void bindMaterials(Mesh* mesh, const MaterialLibrary* lib, const bool report) {
+	free(mesh->materials);
+	mesh->materials = NULL;
+
+	if (mesh->materialCount > 0) {
+		mesh->materials = malloc((size_t)mesh->materialCount * sizeof(const Material*));
+		if (!mesh->materials) {
+			puts("Error allocating mesh materials");
+			raise(SIGTERM);
+		}
+	}
+
+	for (int i=0; i<mesh->materialCount; ++i) {
+		mesh->materials[i] = findMaterial(lib, mesh->materialNames[i].name);
+
+		if (!mesh->materials[i] && report) {
+			printf("Material '%s' isn't in the library, drawn untextured\n", mesh->materialNames[i].name);
+		}
+	}
+
+	for (int i=0; i<mesh->lodCount; ++i) {
+		bindMaterials(&mesh->lods[i], lib, false);
+	}
+}
+
+void bindMeshMaterials(Mesh* mesh, const MaterialLibrary* lib) {
+	bindMaterials(mesh, lib, true);
+}
@@ -0,0 +1,38 @@
+// .mtl material libraries
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_MATERIAL_H
+#define CUBERENDER_MATERIAL_H
+
+#include <SDL3/SDL_render.h>
+
+#include "mesh.h"
+#include "texture.h"
+
+#define RESOURCES_TEXTURES_DIR "resources/textures/"
+
+struct Material {
+	char name[MESH_MATERIAL_NAME_MAX];
+
+	SDL_FColor diffuse;		// Kd, white if the file doesn't set it. Alpha is d (or 1 - Tr)
+	Texture* diffuseMap;	// map_Kd, NULL when untextured or the image failed to load
+
+	SDL_BlendMode blendMode;	// SDL_BLENDMODE_BLEND when the material is see through, NONE otherwise
+};
+
+typedef struct {
+	Material* materials;
+	int count;
+} MaterialLibrary;
+
+// fileName is relative to RESOURCES_TEXTURES_DIR, as are the maps it names. Returns false if the file
+// can't be read, lib is left empty
+bool loadMaterialLibrary(MaterialLibrary* lib, SDL_Renderer* renderer, const char* fileName);
+void freeMaterialLibrary(MaterialLibrary* lib);
+
+const Material* findMaterial(const MaterialLibrary* lib, const char* name);
+
+// Points mesh->materials (and each LOD's) at the library entries matching its usemtl names
+void bindMeshMaterials(Mesh* mesh, const MaterialLibrary* lib);
+
+#endif //CUBERENDER_MATERIAL_H
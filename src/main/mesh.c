@@ -2,23 +2,61 @@
 // Created by James Schaffer on 28/01/2026.
 
 #include "mesh.h"
+#include "meshcache.h"
+#include "meshopt.h"
+#include "objparse.h"
 
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
+#include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
 
-void freeMesh(Mesh* mesh) {
+// Frees what the mesh points to but not the mesh itself (for meshes inside an array)
+void freeMeshData(Mesh* mesh) {
 	if (!mesh) return;
 
-	puts("freeing mesh");
+	if (mesh->mapping) {
+		releaseMeshCacheMapping(mesh->mapping);
+	} else {
+		free(mesh->vertices);
+		free(mesh->faces);
+		free(mesh->normals);
+		free(mesh->texcoords);
+		free(mesh->materialNames);
+	}
+	free(mesh->materials);
+	freeMeshSoA(&mesh->soa);
+	free(mesh->facePlanes);
+	free(mesh->faceRanges);
 
-	free(mesh->vertices);
-	free(mesh->faces);
-	free(mesh->normals);
+	for (int i=0; i<mesh->lodCount; ++i) {
+		freeMeshData(&mesh->lods[i]);
+	}
+	free(mesh->lods);
 
+	mesh->lods = NULL;
+	mesh->lodCount = 0;
 	mesh->vertices = NULL;
 	mesh->faces = NULL;
 	mesh->normals = NULL;
+	mesh->texcoords = NULL;
+	mesh->materialNames = NULL;
+	mesh->materials = NULL;
+	mesh->materialCount = 0;
+	mesh->facePlanes = NULL;
+	mesh->faceRanges = NULL;
+	mesh->faceRangeCount = 0;
+	mesh->mapping = NULL;
+}
+
+void freeMesh(Mesh* mesh) {
+	if (!mesh) return;
+
+	puts("freeing mesh");
 
+	freeMeshData(mesh);
 	free(mesh);
 
 	puts("freed mesh");
@@ -29,172 +67,295 @@ Mesh* loadMeshFromOBJ(const char* fileName, int* meshCount) {
 	char filePath[512];
 	snprintf(filePath, sizeof(filePath), "%s%s", RESOURCES_MESHES_DIR, fileName);
 
-	FILE* fptr = fopen(filePath, "r");
+	char cachePath[sizeof(filePath) + sizeof(MESHCACHE_EXTENSION)];
+	snprintf(cachePath, sizeof(cachePath), "%s%s", filePath, MESHCACHE_EXTENSION);
+
+	// Up to date binary cache, mapped with no parsing
+	// Faces were grouped before the cache was written, so this only finds the ranges again
+	Mesh* cached = loadMeshCache(cachePath, filePath, meshCount);
+	if (cached) {
+		for (int i=0; i<*meshCount; i++) {
+			buildMeshFaceRanges(&cached[i]);
+		}
+		return cached;
+	}
+
+	*meshCount = 0;
+
+	// Whole file in one read, then parsed in parallel chunks
+	size_t length;
+	char* text = readWholeFile(filePath, &length);
 
-	if (fptr == NULL) {
+	if (text == NULL) {
 		puts("Error opening file");
 		return NULL;
 	}
 
-	Mesh* meshArr = NULL;
-	int currentMeshIndex = -1;
-
-	char lineBuffer[MESHLOADER_LINEBUFFER_SIZE];
-	int lineNumb = 0;
-
-	// For each line :
-	while (fgets(lineBuffer, MESHLOADER_LINEBUFFER_SIZE, fptr)) {
-	//	printf(" - %s", lineBuffer);
-
-		lineNumb++;
-		switch (lineBuffer[0]) {
-			// Comment
-			case '#':
-				continue;
-
-			// Material file reference
-			case 'm':
-				break;
-
-			// Use material
-			case 'u':
-				break;
-
-			// Faces
-			case 'f':
-				if (currentMeshIndex == -1) {
-					printf("Error tried to add vertex data before mesh declaration in '%s' : line %i", fileName, lineNumb);
-					raise(SIGTERM);
-				}
-
-				v3* newFaceArr = realloc(meshArr[currentMeshIndex].faces, (meshArr[currentMeshIndex].faceCount +1) * sizeof(Tri));
-				if (!newFaceArr) {
-					printf("Error resizing memory in '%s' : line %i", fileName, lineNumb);
-					raise(SIGTERM);
-				}
-
-				meshArr[currentMeshIndex].faces = newFaceArr;
-
-				Tri newFace = {0};
-				int fCount = sscanf(lineBuffer, "f %i/%*i/%i %i/%*i/%*i %i/%*i/%*i", &newFace.v0, &newFace.n0, &newFace.v1, &newFace.v2);
-
-				// Base 0
-				newFace.v0--; newFace.v1--; newFace.v2--; newFace.n0--;
-
-				if (fCount != 4) {
-					printf("Error reading vertex data (only %i / 4) in '%s' : line %i", fCount, lineBuffer, lineNumb);
-					raise(SIGTERM);
-				}
-
-				meshArr[currentMeshIndex].faceCount++;
-				meshArr[currentMeshIndex].faces[meshArr[currentMeshIndex].faceCount -1] = newFace;
-				break;
-
-			// Line element
-			case 'l':
-				break;
-
-			// Smooth shading
-			case 's':
-				break;
-
-			// New object
-			case 'o':
-				// Allocate memory for new mesh and move pointer (meshCount) along
-				currentMeshIndex++;
-
-				Mesh* newMeshArr = realloc(meshArr, sizeof(Mesh) * (currentMeshIndex +1));
-				if (!newMeshArr) {
-					printf("Error resizing memory in '%s' : line %i", fileName, lineNumb);
-					raise(SIGTERM);
-				}
-
-				meshArr = newMeshArr;
-				meshArr[currentMeshIndex] = (Mesh){0};
-				break;
-
-			// Vertex / texture / normal / paremeter
-			case 'v':
-				if (currentMeshIndex == -1) {
-					printf("Error tried to add vertex data before mesh declaration in '%s' : line %i", fileName, lineNumb);
-					raise(SIGTERM);
-				}
-
-				switch (lineBuffer[1]) {
-					// Vertex
-					case ' ':
-						v3* newVertexArr = realloc(meshArr[currentMeshIndex].vertices, (meshArr[currentMeshIndex].vertexCount +1) * sizeof(struct v3));
-						if (!newVertexArr) {
-							printf("Error resizing memory in '%s' : line %i", fileName, lineNumb);
-							raise(SIGTERM);
-						}
-
-						meshArr[currentMeshIndex].vertices = newVertexArr;
-
-						v3 newVertex = {0};
-						int vCount = sscanf(lineBuffer, "v %lf %lf %lf", &newVertex.x, &newVertex.y, &newVertex.z);
-
-						if (vCount != 3) {
-							printf("Error reading vertex data (only %i / 3) in '%s' : line %i", vCount, lineBuffer, lineNumb);
-							raise(SIGTERM);
-						}
-
-						meshArr[currentMeshIndex].vertexCount++;
-						meshArr[currentMeshIndex].vertices[meshArr[currentMeshIndex].vertexCount -1] = newVertex;
-						break;
-
-					// Normal
-					case 'n':
-						v3* newNormalArr = realloc(meshArr[currentMeshIndex].normals, (meshArr[currentMeshIndex].normalCount +1) * sizeof(struct v3));
-						if (!newNormalArr) {
-							printf("Error resizing memory in '%s' : line %i", fileName, lineNumb);
-							raise(SIGTERM);
-						}
-
-						meshArr[currentMeshIndex].normals = newNormalArr;
-
-						v3 newNormal = {0};
-						int nCount = sscanf(lineBuffer, "vn %lf %lf %lf", &newNormal.x, &newNormal.y, &newNormal.z);
-
-						if (nCount != 3) {
-							printf("Error reading normal data (only %i / 3) in '%s' : line %i", vCount, lineBuffer, lineNumb);
-							raise(SIGTERM);
-						}
-
-						meshArr[currentMeshIndex].normalCount++;
-						meshArr[currentMeshIndex].normals[meshArr[currentMeshIndex].normalCount -1] = newNormal;
-						break;
-					default:
-						printf("Un-recognised (v) element -%s-in '%s' : line %i", &lineBuffer[0], fileName, lineNumb);
-						break;
-				}
-				break;
-
-			// Un-recognised, skip
-			default:
-				printf("Un-recognised element -%s-in '%s' : line %i", &lineBuffer[0], fileName, lineNumb);
-				break;
-		}
+	OBJData data;
+	if (!parseOBJParallel(text, length, &data, SDL_GetNumLogicalCPUCores())) {
+		printf("Error reading obj data in '%s' : line %i\n", fileName, data.errorLine);
+		free(text);
+		freeOBJData(&data);
+		return NULL;
+	}
+
+	Mesh* meshArr = meshesFromOBJData(&data, fileName, meshCount);
+	freeOBJData(&data);
+
+	if (!meshArr) {
+		printf("No meshes loaded from '%s'\n", fileName);
+		free(text);
+		return NULL;
 	}
 
-	fclose(fptr);
+#if OPTIMIZE_MESHES
+	// ACMR before / after is weighted by face count across all meshes
+	MeshOptimizeStats optStats = {0};
+	size_t optFaces = 0;
+	Uint64 optTicks = 0;
+#endif
+
+	for (int i=0; i<*meshCount; i++) {
+		computeMeshBounds(&meshArr[i]);
+
+#if MESH_SMOOTH_NORMALS
+		// Before the cache is written so mapped loads already have them
+		smoothMeshNormals(&meshArr[i], MESH_SMOOTH_CREASE_DEGREES);
+#endif
+
+		buildMeshFaceRanges(&meshArr[i]);
+
+#if OPTIMIZE_MESHES
+		// Also before the cache is written, a mapped mesh is already optimised (reordering it would copy every page)
+		MeshOptimizeStats stats;
+		const Uint64 optStart = SDL_GetPerformanceCounter();
+		optimizeMesh(&meshArr[i], &stats);
+		optTicks += SDL_GetPerformanceCounter() - optStart;
+
+		optStats.verticesBefore += stats.verticesBefore;
+		optStats.verticesAfter += stats.verticesAfter;
+		optStats.acmrBefore += stats.acmrBefore * meshArr[i].faceCount;
+		optStats.acmrAfter += stats.acmrAfter * meshArr[i].faceCount;
+		optFaces += meshArr[i].faceCount;
+#endif
+	}
 
-	// Debug print
-	// for (int i=0; i<currentMeshIndex+1; i++) {
-	// 	printf("%i : \n", i);
-	// 	for (int j=0; j<meshArr[i].vertexCount; j++) {
-	// 		printf(" - v : %f %f %f\n", meshArr[i].vertices[j].x, meshArr[i].vertices[j].y, meshArr[i].vertices[j].z);
-	// 	}
-	// 	for (int j=0; j<meshArr[i].normalCount; j++) {
-	// 		printf(" - n : %f %f %f\n", meshArr[i].normals[j].x, meshArr[i].normals[j].y, meshArr[i].normals[j].z);
-	// 	}
-	// 	for (int j=0; j<meshArr[i].faceCount; j++) {
-	// 		printf(" - f : %i %i %i : %i\n", meshArr[i].faces[j].v0, meshArr[i].faces[j].v1, meshArr[i].faces[j].v2, meshArr[i].faces[j].n0);
-	// 	}
-	// }
+#if OPTIMIZE_MESHES
+	if (optFaces > 0) {
+		printf("Optimised meshes in %.1fms : vertices %i -> %i, ACMR %.3f -> %.3f\n",
+			(double)optTicks * 1000.0 / (double)SDL_GetPerformanceFrequency(),
+			(int)optStats.verticesBefore, (int)optStats.verticesAfter,
+			optStats.acmrBefore / optFaces, optStats.acmrAfter / optFaces);
+	}
+#endif
 
-	puts("HI");
+	// Next load maps this instead
+	writeMeshCache(cachePath, filePath, text, length, meshArr, *meshCount);
+	free(text);
 
-	(*meshCount) = (currentMeshIndex+1);
 	return meshArr;
-}
\ No newline at end of file
+}
+
+// ========== BOUNDS ==========
+
+// AABB plus a sphere around the AABB center, the sphere is the cheaper test so it's checked first
+void computeMeshBounds(Mesh* mesh) {
+	if (mesh->vertexCount == 0) {
+		mesh->bounds = (AABB){0};
+		mesh->boundingSphere = (Sphere){0};
+		return;
+	}
+
+	AABB box = { mesh->vertices[0], mesh->vertices[0] };
+
+	for (size_t i=1; i<mesh->vertexCount; ++i) {
+		const v3 v = mesh->vertices[i];
+
+		if (v.x < box.min.x) box.min.x = v.x;
+		if (v.y < box.min.y) box.min.y = v.y;
+		if (v.z < box.min.z) box.min.z = v.z;
+		if (v.x > box.max.x) box.max.x = v.x;
+		if (v.y > box.max.y) box.max.y = v.y;
+		if (v.z > box.max.z) box.max.z = v.z;
+	}
+
+	const v3 center = v3Scale(v3Add(box.min, box.max), 0.5);
+
+	double radiusSq = 0;
+	for (size_t i=0; i<mesh->vertexCount; ++i) {
+		const v3 d = v3Sub(mesh->vertices[i], center);
+		const double lenSq = dotProduct(d, d);
+
+		if (lenSq > radiusSq) radiusSq = lenSq;
+	}
+
+	mesh->bounds = box;
+	mesh->boundingSphere = (Sphere){ center, sqrt(radiusSq) };
+}
+
+// ========== FLOAT SOA MIRROR ==========
+
+static float* allocSoAStream(size_t count) {
+	// Rounded up to whole 8 wide vectors so kernels never straddle the end of an allocation
+	const size_t padded = (count + 7) & ~(size_t)7;
+
+	float* stream = SDL_aligned_alloc(MESH_SOA_ALIGN, (padded ? padded : 8) * sizeof(float));
+	if (!stream) {
+		puts("Error allocating mesh SoA stream");
+		raise(SIGTERM);
+	}
+
+	memset(stream, 0, (padded ? padded : 8) * sizeof(float));
+	return stream;
+}
+
+// (Re)builds the float SoA copy of the vertex and normal data, the v3 arrays stay the source of truth
+void buildMeshSoA(Mesh* mesh) {
+	freeMeshSoA(&mesh->soa);
+
+	MeshSoA* soa = &mesh->soa;
+
+	soa->x = allocSoAStream(mesh->vertexCount);
+	soa->y = allocSoAStream(mesh->vertexCount);
+	soa->z = allocSoAStream(mesh->vertexCount);
+
+	for (size_t i=0; i<mesh->vertexCount; ++i) {
+		soa->x[i] = (float)mesh->vertices[i].x;
+		soa->y[i] = (float)mesh->vertices[i].y;
+		soa->z[i] = (float)mesh->vertices[i].z;
+	}
+
+	soa->nx = allocSoAStream(mesh->normalCount);
+	soa->ny = allocSoAStream(mesh->normalCount);
+	soa->nz = allocSoAStream(mesh->normalCount);
+
+	for (size_t i=0; i<mesh->normalCount; ++i) {
+		soa->nx[i] = (float)mesh->normals[i].x;
+		soa->ny[i] = (float)mesh->normals[i].y;
+		soa->nz[i] = (float)mesh->normals[i].z;
+	}
+
+	soa->count = mesh->vertexCount;
+	soa->normalCount = mesh->normalCount;
+}
+
+void freeMeshSoA(MeshSoA* soa) {
+	if (!soa) return;
+
+	SDL_aligned_free(soa->x);
+	SDL_aligned_free(soa->y);
+	SDL_aligned_free(soa->z);
+	SDL_aligned_free(soa->nx);
+	SDL_aligned_free(soa->ny);
+	SDL_aligned_free(soa->nz);
+
+	*soa = (MeshSoA){0};
+}
+
+// ========== MATERIAL RANGES ==========
+
+// Groups the faces so each material's are contiguous, then records one range per material. Stable, so faces
+// keep their file order inside a material. Faces before any usemtl (-1) come first, then materials in first use order
+void buildMeshFaceRanges(Mesh* mesh) {
+	free(mesh->faceRanges);
+	mesh->faceRanges = NULL;
+	mesh->faceRangeCount = 0;
+
+	if (mesh->faceCount == 0) return;
+
+	// Bucket 0 is "no material", bucket m+1 is material m
+	const int bucketCount = mesh->materialCount + 1;
+	int* start = calloc((size_t)bucketCount + 1, sizeof(int));
+	if (!start) {
+		puts("Error allocating face ranges");
+		raise(SIGTERM);
+	}
+
+	bool grouped = true;
+	int previous = -1;
+
+	for (size_t i=0; i<mesh->faceCount; ++i) {
+		const int bucket = mesh->faces[i].material + 1;
+		start[bucket + 1]++;
+
+		// Already in bucket order (always the case for a cached mesh) means nothing has to move
+		if (bucket < previous) grouped = false;
+		previous = bucket;
+	}
+
+	for (int b=0; b<bucketCount; ++b) {
+		start[b + 1] += start[b];
+		if (start[b + 1] > start[b]) mesh->faceRangeCount++;
+	}
+
+	if (!grouped) {
+		Tri* sorted = malloc(mesh->faceCount * sizeof(Tri));
+		int* cursor = malloc((size_t)bucketCount * sizeof(int));
+		if (!sorted || !cursor) {
+			puts("Error allocating face ranges");
+			raise(SIGTERM);
+		}
+
+		memcpy(cursor, start, (size_t)bucketCount * sizeof(int));
+
+		for (size_t i=0; i<mesh->faceCount; ++i) {
+			sorted[cursor[mesh->faces[i].material + 1]++] = mesh->faces[i];
+		}
+
+		// Mapped faces are a private copy-on-write view so this never reaches the cache file
+		memcpy(mesh->faces, sorted, mesh->faceCount * sizeof(Tri));
+		free(sorted);
+		free(cursor);
+	}
+
+	mesh->faceRanges = malloc((size_t)mesh->faceRangeCount * sizeof(MeshFaceRange));
+	if (!mesh->faceRanges) {
+		puts("Error allocating face ranges");
+		raise(SIGTERM);
+	}
+
+	int r = 0;
+	for (int b=0; b<bucketCount; ++b) {
+		if (start[b + 1] == start[b]) continue;
+
+		mesh->faceRanges[r++] = (MeshFaceRange){ b - 1, start[b], start[b + 1] - start[b] };
+	}
+
+	free(start);
+}
+
+// Geometric normal from the winding, flipped if it disagrees with the corner normals so files wound
+// the other way still cull correctly. Degenerate faces fall back to the corner normals
+v3 meshFaceNormal(const Mesh* mesh, const Tri face) {
+	const v3 v0 = mesh->vertices[face.v0];
+	const v3 cornerSum = v3Add(v3Add(mesh->normals[face.n0], mesh->normals[face.n1]), mesh->normals[face.n2]);
+
+	v3 normal = crossProduct(v3Sub(mesh->vertices[face.v1], v0), v3Sub(mesh->vertices[face.v2], v0));
+	if (v3Len(normal) == 0) {
+		normal = cornerSum;
+	} else if (dotProduct(normal, cornerSum) < 0) {
+		normal = v3Scale(normal, -1);
+	}
+
+	return v3Len(normal) > 0 ? normalize(normal) : normal;
+}
+
+// Plane through each face for back-face culling. Shading is per vertex so the corner normals can't be
+// used on their own, a silhouette face would be culled or kept depending on which corner came first
+void buildMeshFacePlanes(Mesh* mesh) {
+	free(mesh->facePlanes);
+
+	mesh->facePlanes = malloc(mesh->faceCount * sizeof(v4));
+	if (!mesh->facePlanes && mesh->faceCount > 0) {
+		puts("Error allocating face planes");
+		raise(SIGTERM);
+	}
+
+	for (size_t i=0; i<mesh->faceCount; ++i) {
+		const Tri face = mesh->faces[i];
+		const v3 v0 = mesh->vertices[face.v0];
+		const v3 normal = meshFaceNormal(mesh, face);
+
+		mesh->facePlanes[i] = (v4){ normal.x, normal.y, normal.z, -dotProduct(normal, v0) };
+	}
+}
@@ -8,30 +8,112 @@
 #define _CRT_SECURE_NO_DEPRECATE
 
 #define RESOURCES_MESHES_DIR "resources/meshes/"
-#define MESHLOADER_LINEBUFFER_SIZE 512
+
+#define MESH_SOA_ALIGN 32
+
+// Longest material / material library name kept from an .obj, including the terminator
+#define MESH_MATERIAL_NAME_MAX 64
+
+// Flat shaded exports get per vertex normals at load for the smooth shading, faces meeting at a sharper
+// angle than MESH_SMOOTH_CREASE_DEGREES keep a hard edge. 0 shades them faceted as exported
+#define MESH_SMOOTH_NORMALS			1
+#define MESH_SMOOTH_CREASE_DEGREES	60.0
+
+// Weld and reorder meshes for vertex locality before the cache is written, 0 keeps the exporter's order
+#define OPTIMIZE_MESHES		1
 
 #include <SDL3/SDL_pixels.h>
 #include "vector.h"
 
 typedef struct {
 	int v0, v1, v2; // vertex array index
-	int n0; // normal array index
-	//int t0, t1, t2; // texcoord indices
+	int n0, n1, n2; // normal array index per corner
+	int t0, t1, t2; // texcoord array index per corner, -1 without one
+	int material; // materialNames index, -1 before any usemtl
 } Tri;
 
-typedef struct  {
+typedef struct {
+	char name[MESH_MATERIAL_NAME_MAX];
+} MeshMaterialName;
+
+// Run of faces[first .. first+count) that all use the same material
+typedef struct {
+	int material;
+	int first, count;
+} MeshFaceRange;
+
+// Optional float structure-of-arrays mirror of vertices and normals for the SIMD passes
+// Each array is aligned to MESH_SOA_ALIGN
+typedef struct {
+	float* x;
+	float* y;
+	float* z;
+
+	float* nx;
+	float* ny;
+	float* nz;
+
+	size_t count, normalCount;
+} MeshSoA;
+
+// Defined in meshcache.h
+typedef struct MeshCacheMapping MeshCacheMapping;
+
+// Defined in material.h
+typedef struct Material Material;
+
+typedef struct Mesh {
 	v3* vertices;
 	v3* normals;
+	v2* texcoords;
 	Tri* faces;
 
 	SDL_FColor color;
 
-	size_t vertexCount, normalCount, faceCount;
+	size_t vertexCount, normalCount, texcoordCount, faceCount;
+
+	// The usemtl names faces refer to, in first use order, and the mtllib the file asked for ("" without one).
+	// materials has the library entry for each name (NULL if missing), set by bindMeshMaterials
+	MeshMaterialName* materialNames;
+	const Material** materials;
+	int materialCount;
+	char materialLibrary[MESH_MATERIAL_NAME_MAX];
+
+	// Object space bounds, set at load
+	AABB bounds;
+	Sphere boundingSphere;
+
+	MeshSoA soa;
+
+	// Faces grouped by material at load, one range per material used (see buildMeshFaceRanges)
+	MeshFaceRange* faceRanges;
+	int faceRangeCount;
+
+	// Object space plane of each face from buildMeshFacePlanes : xyz = meshFaceNormal, w = -dot(normal, v0)
+	v4* facePlanes;
+
+	// Set when vertices / normals / texcoords / faces / materialNames point into a mapped cache file instead of the heap
+	MeshCacheMapping* mapping;
+
+	// Simplified copies from buildMeshLODs, each coarser than the last (owned by this mesh)
+	struct Mesh* lods;
+	int lodCount;
 } Mesh;
 
 Mesh newMesh();
+void freeMeshData(Mesh* mesh);
 void freeMesh(Mesh* mesh);
 
 Mesh* loadMeshFromOBJ(const char* fileName, int* meshCount);
 
+void computeMeshBounds(Mesh* mesh);
+
+void buildMeshSoA(Mesh* mesh);
+void freeMeshSoA(MeshSoA* soa);
+
+void buildMeshFaceRanges(Mesh* mesh);
+
+v3 meshFaceNormal(const Mesh* mesh, Tri face);
+void buildMeshFacePlanes(Mesh* mesh);
+
 #endif //CUBERENDER_MESHLOADER_H
\ No newline at end of file
@@ -0,0 +1,367 @@
+// Binary mesh cache, memory mapped so meshes load without parsing
+// Created by James Schaffer on 16/10/2026.
+
+#include "meshcache.h"
+#include "objparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_log.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// ========== HASH ==========
+
+// FNV-1a over 8 byte words with a final mix, only used to tell whether a source file changed
+Uint64 hashBytes(const void* data, size_t length) {
+	const Uint8* p = data;
+	Uint64 hash = 0xCBF29CE484222325ULL ^ length;
+
+	for (; length >= 8; p += 8, length -= 8) {
+		Uint64 word;
+		memcpy(&word, p, 8);
+
+		hash = (hash ^ word) * 0x100000001B3ULL;
+		hash ^= hash >> 29;
+	}
+
+	Uint64 tail = 0;
+	memcpy(&tail, p, length);
+	hash = (hash ^ tail) * 0x100000001B3ULL;
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+// ========== MAPPING ==========
+
+// Copy on write mapping, so meshes can still be edited in memory without touching the file
+static bool mapFile(const char* path, MeshCacheMapping* mapping) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE map = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!map) return false;
+
+	// The view keeps the mapping alive on its own
+	void* base = MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(map);
+	if (!base) return false;
+
+	mapping->base = base;
+	mapping->size = (size_t)size.QuadPart;
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+
+	const off_t size = lseek(fd, 0, SEEK_END);
+	if (size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	void* base = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) return false;
+
+	mapping->base = base;
+	mapping->size = (size_t)size;
+#endif
+
+	return true;
+}
+
+static void unmapFile(MeshCacheMapping* mapping) {
+#ifdef _WIN32
+	UnmapViewOfFile(mapping->base);
+#else
+	munmap(mapping->base, mapping->size);
+#endif
+}
+
+// Called once per mesh pointing into the mapping, the last one unmaps it
+void releaseMeshCacheMapping(MeshCacheMapping* mapping) {
+	if (!mapping) return;
+	if (--mapping->refs > 0) return;
+
+	unmapFile(mapping);
+	free(mapping);
+}
+
+// ========== LOADING ==========
+
+static bool readHeader(const char* cachePath, MeshCacheHeader* header) {
+	FILE* fptr = fopen(cachePath, "rb");
+	if (fptr == NULL) return false;
+
+	const bool ok = fread(header, sizeof(MeshCacheHeader), 1, fptr) == 1;
+	fclose(fptr);
+
+	return ok;
+}
+
+static bool headerMatchesBuild(const MeshCacheHeader* header) {
+	return header->magic == MESHCACHE_MAGIC &&
+		header->version == MESHCACHE_VERSION &&
+		header->headerSize == sizeof(MeshCacheHeader) &&
+		header->entrySize == sizeof(MeshCacheEntry) &&
+		header->vertexSize == sizeof(v3) &&
+		header->faceSize == sizeof(Tri);
+}
+
+// Size and mtime are checked first, the source is only read and hashed when its mtime moved (a touch or a
+// checkout keeps the cache if the content is the same, and the new mtime is written back)
+static bool sourceMatches(const char* cachePath, MeshCacheHeader* header, const char* sourcePath, const SDL_PathInfo* source) {
+	if (header->sourceSize != source->size) return false;
+	if (header->sourceMtime == source->modify_time) return true;
+
+	size_t length;
+	char* text = readWholeFile(sourcePath, &length);
+	if (!text) return false;
+
+	const bool same = length == header->sourceSize && hashBytes(text, length) == header->sourceHash;
+	free(text);
+
+	if (!same) return false;
+
+	header->sourceMtime = source->modify_time;
+
+	FILE* fptr = fopen(cachePath, "r+b");
+	if (fptr) {
+		fwrite(header, sizeof(MeshCacheHeader), 1, fptr);
+		fclose(fptr);
+	}
+
+	return true;
+}
+
+static bool arrayInFile(const MeshCacheHeader* header, const Uint64 offset, const Uint64 count, const size_t elemSize) {
+	if (count == 0) return true;
+	if (offset % MESHCACHE_ALIGN != 0 || offset > header->fileSize) return false;
+
+	return count <= (header->fileSize - offset) / elemSize;
+}
+
+// Returns NULL if there's no cache or it's stale, otherwise meshes whose arrays point straight into the mapping
+Mesh* loadMeshCache(const char* cachePath, const char* sourcePath, int* meshCount) {
+	*meshCount = 0;
+
+	SDL_PathInfo source, cache;
+	if (!SDL_GetPathInfo(sourcePath, &source) || !SDL_GetPathInfo(cachePath, &cache)) return NULL;
+
+	MeshCacheHeader header;
+	if (!readHeader(cachePath, &header)) return NULL;
+
+	if (!headerMatchesBuild(&header) || header.fileSize != cache.size || header.meshCount == 0) return NULL;
+	if (!sourceMatches(cachePath, &header, sourcePath, &source)) return NULL;
+
+	MeshCacheMapping* mapping = calloc(1, sizeof(MeshCacheMapping));
+	if (!mapping) return NULL;
+
+	if (!mapFile(cachePath, mapping) || mapping->size != header.fileSize) {
+		if (mapping->base) unmapFile(mapping);
+		free(mapping);
+		return NULL;
+	}
+
+	const Uint8* base = mapping->base;
+	const MeshCacheEntry* entries = (const MeshCacheEntry*)(base + sizeof(MeshCacheHeader));
+
+	Mesh* meshArr = NULL;
+	bool valid = sizeof(MeshCacheHeader) + (Uint64)header.meshCount * sizeof(MeshCacheEntry) <= header.fileSize;
+
+	for (Uint32 i=0; valid && i<header.meshCount; ++i) {
+		const MeshCacheEntry* e = &entries[i];
+
+		valid = arrayInFile(&header, e->vertexOffset, e->vertexCount, sizeof(v3)) &&
+			arrayInFile(&header, e->normalOffset, e->normalCount, sizeof(v3)) &&
+			arrayInFile(&header, e->texcoordOffset, e->texcoordCount, sizeof(v2)) &&
+			arrayInFile(&header, e->faceOffset, e->faceCount, sizeof(Tri)) &&
+			arrayInFile(&header, e->materialOffset, e->materialCount, sizeof(MeshMaterialName)) &&
+			e->materialCount <= SDL_MAX_SINT32;
+	}
+
+	if (valid) meshArr = calloc(header.meshCount, sizeof(Mesh));
+
+	if (!meshArr) {
+		unmapFile(mapping);
+		free(mapping);
+		return NULL;
+	}
+
+	for (Uint32 i=0; i<header.meshCount; ++i) {
+		const MeshCacheEntry* e = &entries[i];
+		Mesh* mesh = &meshArr[i];
+
+		mesh->vertexCount = (size_t)e->vertexCount;
+		mesh->normalCount = (size_t)e->normalCount;
+		mesh->texcoordCount = (size_t)e->texcoordCount;
+		mesh->faceCount = (size_t)e->faceCount;
+		mesh->materialCount = (int)e->materialCount;
+
+		mesh->vertices = e->vertexCount ? (v3*)(base + e->vertexOffset) : NULL;
+		mesh->normals = e->normalCount ? (v3*)(base + e->normalOffset) : NULL;
+		mesh->texcoords = e->texcoordCount ? (v2*)(base + e->texcoordOffset) : NULL;
+		mesh->faces = e->faceCount ? (Tri*)(base + e->faceOffset) : NULL;
+		mesh->materialNames = e->materialCount ? (MeshMaterialName*)(base + e->materialOffset) : NULL;
+
+		memcpy(mesh->materialLibrary, e->materialLibrary, sizeof(mesh->materialLibrary));
+		mesh->materialLibrary[sizeof(mesh->materialLibrary) - 1] = '\0';
+
+		mesh->bounds = e->bounds;
+		mesh->boundingSphere = e->boundingSphere;
+
+		mesh->mapping = mapping;
+	}
+
+	mapping->refs = (int)header.meshCount;
+	*meshCount = (int)header.meshCount;
+
+	return meshArr;
+}
+
+// ========== WRITING ==========
+
+static Uint64 alignOffset(const Uint64 offset) {
+	return (offset + MESHCACHE_ALIGN - 1) & ~(Uint64)(MESHCACHE_ALIGN - 1);
+}
+
+static bool writeArray(FILE* fptr, Uint64* offset, const Uint64 at, const void* data, const size_t bytes) {
+	static const Uint8 zeros[MESHCACHE_ALIGN] = {0};
+
+	if (bytes == 0) return true;
+
+	if (at > *offset && fwrite(zeros, 1, (size_t)(at - *offset), fptr) != at - *offset) return false;
+	if (fwrite(data, 1, bytes, fptr) != bytes) return false;
+
+	*offset = at + bytes;
+	return true;
+}
+
+// Writes to a temporary file first so a half written cache is never picked up
+bool writeMeshCache(const char* cachePath, const char* sourcePath, const char* sourceText, const size_t sourceLength, const Mesh* meshes, const int meshCount) {
+	SDL_PathInfo source;
+	if (meshCount <= 0 || !SDL_GetPathInfo(sourcePath, &source) || source.size != sourceLength) return false;
+
+	MeshCacheEntry* entries = calloc(meshCount, sizeof(MeshCacheEntry));
+	if (!entries) return false;
+
+	// Lay every array out after the header and entry table
+	Uint64 offset = sizeof(MeshCacheHeader) + (Uint64)meshCount * sizeof(MeshCacheEntry);
+
+	for (int i=0; i<meshCount; ++i) {
+		const Mesh* mesh = &meshes[i];
+		MeshCacheEntry* e = &entries[i];
+
+		e->vertexCount = mesh->vertexCount;
+		e->normalCount = mesh->normalCount;
+		e->texcoordCount = mesh->texcoordCount;
+		e->faceCount = mesh->faceCount;
+		e->materialCount = (Uint64)mesh->materialCount;
+		memcpy(e->materialLibrary, mesh->materialLibrary, sizeof(e->materialLibrary));
+		e->bounds = mesh->bounds;
+		e->boundingSphere = mesh->boundingSphere;
+
+		if (mesh->vertexCount) {
+			e->vertexOffset = alignOffset(offset);
+			offset = e->vertexOffset + mesh->vertexCount * sizeof(v3);
+		}
+		if (mesh->normalCount) {
+			e->normalOffset = alignOffset(offset);
+			offset = e->normalOffset + mesh->normalCount * sizeof(v3);
+		}
+		if (mesh->texcoordCount) {
+			e->texcoordOffset = alignOffset(offset);
+			offset = e->texcoordOffset + mesh->texcoordCount * sizeof(v2);
+		}
+		if (mesh->faceCount) {
+			e->faceOffset = alignOffset(offset);
+			offset = e->faceOffset + mesh->faceCount * sizeof(Tri);
+		}
+		if (mesh->materialCount) {
+			e->materialOffset = alignOffset(offset);
+			offset = e->materialOffset + (Uint64)mesh->materialCount * sizeof(MeshMaterialName);
+		}
+	}
+
+	const MeshCacheHeader header = {
+		.magic = MESHCACHE_MAGIC,
+		.version = MESHCACHE_VERSION,
+		.headerSize = sizeof(MeshCacheHeader),
+		.entrySize = sizeof(MeshCacheEntry),
+		.vertexSize = sizeof(v3),
+		.faceSize = sizeof(Tri),
+		.meshCount = (Uint32)meshCount,
+		.fileSize = offset,
+		.sourceSize = source.size,
+		.sourceMtime = source.modify_time,
+		.sourceHash = hashBytes(sourceText, sourceLength)
+	};
+
+	// Sized from cachePath, a truncated name would be written and renamed from the wrong file
+	const size_t tmpSize = strlen(cachePath) + sizeof(".tmp");
+	char* tmpPath = malloc(tmpSize);
+	if (!tmpPath) {
+		free(entries);
+		return false;
+	}
+	snprintf(tmpPath, tmpSize, "%s.tmp", cachePath);
+
+	FILE* fptr = fopen(tmpPath, "wb");
+	if (fptr == NULL) {
+		free(tmpPath);
+		free(entries);
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+		fwrite(entries, sizeof(MeshCacheEntry), meshCount, fptr) == (size_t)meshCount;
+
+	Uint64 written = sizeof(MeshCacheHeader) + (Uint64)meshCount * sizeof(MeshCacheEntry);
+
+	for (int i=0; ok && i<meshCount; ++i) {
+		const Mesh* mesh = &meshes[i];
+		const MeshCacheEntry* e = &entries[i];
+
+		ok = writeArray(fptr, &written, e->vertexOffset, mesh->vertices, mesh->vertexCount * sizeof(v3)) &&
+			writeArray(fptr, &written, e->normalOffset, mesh->normals, mesh->normalCount * sizeof(v3)) &&
+			writeArray(fptr, &written, e->texcoordOffset, mesh->texcoords, mesh->texcoordCount * sizeof(v2)) &&
+			writeArray(fptr, &written, e->faceOffset, mesh->faces, mesh->faceCount * sizeof(Tri)) &&
+			writeArray(fptr, &written, e->materialOffset, mesh->materialNames, (size_t)mesh->materialCount * sizeof(MeshMaterialName));
+	}
+
+	ok = fclose(fptr) == 0 && ok;
+	free(entries);
+
+	// rename() won't replace an existing file on Windows
+	remove(cachePath);
+	if (!ok || rename(tmpPath, cachePath) != 0) {
+		SDL_Log("Failed to write mesh cache '%s'", cachePath);
+		remove(tmpPath);
+		free(tmpPath);
+		return false;
+	}
+
+	free(tmpPath);
+	return true;
+}
@@ -0,0 +1,64 @@
+// Binary mesh cache, memory mapped so meshes load without parsing
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_MESHCACHE_H
+#define CUBERENDER_MESHCACHE_H
+
+#include <SDL3/SDL_stdinc.h>
+
+#include "mesh.h"
+
+// Written next to the source, e.g. cat.obj -> cat.obj.meshcache
+#define MESHCACHE_EXTENSION ".meshcache"
+
+#define MESHCACHE_MAGIC		0x48534D43 // "CMSH"
+#define MESHCACHE_VERSION	4
+
+// Every array starts on this boundary inside the file (the mapping itself is page aligned)
+#define MESHCACHE_ALIGN 32
+
+// File layout : header, meshCount entries, then the vertex / normal / texcoord / face / material name arrays exactly as Mesh uses them
+typedef struct {
+	Uint32 magic;
+	Uint32 version;
+
+	// Catch a cache written by a build with a different struct layout
+	Uint32 headerSize, entrySize;
+	Uint32 vertexSize, faceSize;
+
+	Uint32 meshCount;
+	Uint32 pad;
+
+	Uint64 fileSize;
+
+	// Source the cache was built from
+	Uint64 sourceSize;
+	Sint64 sourceMtime;
+	Uint64 sourceHash;
+} MeshCacheHeader;
+
+typedef struct {
+	Uint64 vertexOffset, normalOffset, texcoordOffset, faceOffset, materialOffset;
+	Uint64 vertexCount, normalCount, texcoordCount, faceCount, materialCount;
+
+	char materialLibrary[MESH_MATERIAL_NAME_MAX];
+
+	AABB bounds;
+	Sphere boundingSphere;
+} MeshCacheEntry;
+
+// A mapped cache file, shared by every mesh that points into it
+struct MeshCacheMapping {
+	void* base;
+	size_t size;
+	int refs;
+};
+
+Mesh* loadMeshCache(const char* cachePath, const char* sourcePath, int* meshCount);
+bool writeMeshCache(const char* cachePath, const char* sourcePath, const char* sourceText, size_t sourceLength, const Mesh* meshes, int meshCount);
+
+void releaseMeshCacheMapping(MeshCacheMapping* mapping);
+
+Uint64 hashBytes(const void* data, size_t length);
+
+#endif //CUBERENDER_MESHCACHE_H
@@ -0,0 +1,541 @@
+// Load time mesh optimisation (welding, cache friendly ordering and smooth normals)
+// Created by James Schaffer on 16/10/2026.
+
+#include "meshopt.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* allocOrDie(const size_t count, const size_t elemSize) {
+	void* ptr = malloc((count ? count : 1) * elemSize);
+	if (!ptr) {
+		puts("Error allocating mesh optimisation buffer");
+		raise(SIGTERM);
+	}
+	return ptr;
+}
+
+// Runs every pass in order, stats can be NULL.
+// Mapped meshes were optimised before their cache was written so they're left alone
+void optimizeMesh(Mesh* mesh, MeshOptimizeStats* stats) {
+	if (mesh->mapping) {
+		if (stats) {
+			const double acmr = meshACMR(mesh, MESHOPT_ACMR_CACHE_SIZE);
+			*stats = (MeshOptimizeStats){ mesh->vertexCount, mesh->vertexCount, acmr, acmr };
+		}
+		return;
+	}
+
+	if (stats) {
+		stats->verticesBefore = mesh->vertexCount;
+		stats->acmrBefore = meshACMR(mesh, MESHOPT_ACMR_CACHE_SIZE);
+	}
+
+	weldMeshVertices(mesh);
+	optimizeFaceOrder(mesh);
+	reorderVerticesByFirstUse(mesh);
+
+	if (stats) {
+		stats->verticesAfter = mesh->vertexCount;
+		stats->acmrAfter = meshACMR(mesh, MESHOPT_ACMR_CACHE_SIZE);
+	}
+}
+
+// ========== WELDING ==========
+
+static Uint64 hashPosition(const v3 v) {
+	// + 0.0 folds -0.0 into 0.0 so they hash the same as they compare
+	const double c[3] = { v.x + 0.0, v.y + 0.0, v.z + 0.0 };
+	Uint64 hash = 0xCBF29CE484222325ULL;
+
+	for (int i=0; i<3; ++i) {
+		Uint64 bits;
+		memcpy(&bits, &c[i], sizeof(bits));
+
+		hash = (hash ^ bits) * 0x100000001B3ULL;
+		hash ^= hash >> 32;
+	}
+
+	return hash;
+}
+
+// Merges vertices with exactly the same position, returns how many were removed.
+// Faces are remapped, the vertex array is compacted in place (first copy of each position is kept)
+size_t weldMeshVertices(Mesh* mesh) {
+	const size_t count = mesh->vertexCount;
+	if (count == 0) return 0;
+
+	// Open addressing table of vertex indices, at most half full
+	size_t tableSize = 1;
+	while (tableSize < count * 2) tableSize <<= 1;
+
+	int* table = allocOrDie(tableSize, sizeof(int));
+	int* remap = allocOrDie(count, sizeof(int));
+	memset(table, 0xFF, tableSize * sizeof(int));
+
+	size_t unique = 0;
+
+	for (size_t i=0; i<count; ++i) {
+		const v3 v = mesh->vertices[i];
+		size_t slot = hashPosition(v) & (tableSize - 1);
+
+		for (;;) {
+			const int existing = table[slot];
+
+			if (existing < 0) {
+				// New position, compacted down to the next free index
+				table[slot] = (int)unique;
+				mesh->vertices[unique] = v;
+				remap[i] = (int)unique++;
+				break;
+			}
+
+			const v3 e = mesh->vertices[existing];
+			if (e.x == v.x && e.y == v.y && e.z == v.z) {
+				remap[i] = existing;
+				break;
+			}
+
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+
+	for (size_t f=0; f<mesh->faceCount; ++f) {
+		Tri* t = &mesh->faces[f];
+
+		t->v0 = remap[t->v0];
+		t->v1 = remap[t->v1];
+		t->v2 = remap[t->v2];
+	}
+
+	free(table);
+	free(remap);
+
+	mesh->vertexCount = unique;
+	return count - unique;
+}
+
+// ========== FACE ORDER ==========
+// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" : greedily emit the face whose vertices score
+// highest, vertices score for being recently used (in a simulated LRU cache) and for having few faces left
+
+#define FORSYTH_CACHE_DECAY_POWER	1.5f
+#define FORSYTH_LAST_TRI_SCORE		0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE	2.0f
+#define FORSYTH_VALENCE_BOOST_POWER	0.5f
+
+// Valence boosts past this many faces are computed directly, below it they come from a table
+#define FORSYTH_VALENCE_TABLE_SIZE 32
+
+static float forsythCacheScore[MESHOPT_FORSYTH_CACHE_SIZE];
+static float forsythValenceScore[FORSYTH_VALENCE_TABLE_SIZE];
+static bool forsythTablesReady = false;
+
+static void initForsythTables() {
+	for (int i=0; i<MESHOPT_FORSYTH_CACHE_SIZE; ++i) {
+		if (i < 3) {
+			// The last triangle's vertices get a fixed score so the order doesn't just strip along
+			forsythCacheScore[i] = FORSYTH_LAST_TRI_SCORE;
+		} else {
+			const float scale = 1.0f / (MESHOPT_FORSYTH_CACHE_SIZE - 3);
+			forsythCacheScore[i] = powf(1.0f - (i - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+
+	for (int i=1; i<FORSYTH_VALENCE_TABLE_SIZE; ++i) {
+		forsythValenceScore[i] = FORSYTH_VALENCE_BOOST_SCALE * powf((float)i, -FORSYTH_VALENCE_BOOST_POWER);
+	}
+
+	forsythTablesReady = true;
+}
+
+static float forsythVertexScore(const int cachePosition, const int remainingFaces) {
+	if (remainingFaces == 0) return -1.0f;
+
+	const float score = cachePosition >= 0 ? forsythCacheScore[cachePosition] : 0.0f;
+
+	// Boost vertices with few faces left so they get finished off instead of left as stragglers
+	if (remainingFaces < FORSYTH_VALENCE_TABLE_SIZE) {
+		return score + forsythValenceScore[remainingFaces];
+	}
+	return score + FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingFaces, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+static void triCorners(const Tri* t, int corners[3]) {
+	corners[0] = t->v0;
+	corners[1] = t->v1;
+	corners[2] = t->v2;
+}
+
+// Corner i is skipped if it repeats an earlier corner (degenerate faces after welding)
+static bool repeatedCorner(const int corners[3], const int i) {
+	return (i > 0 && corners[i] == corners[0]) || (i > 1 && corners[i] == corners[1]);
+}
+
+// Orders faces[0 .. faceCount) on their own, vertex indices still span the whole mesh
+static void optimizeFaceRun(Tri* faces, const size_t faceCount, const size_t vertexCount) {
+	if (faceCount < 2 || vertexCount == 0) return;
+
+	if (!forsythTablesReady) initForsythTables();
+
+	// Per vertex list of faces still to emit (CSR layout, active entries at the front of each list)
+	int* faceStart = allocOrDie(vertexCount + 1, sizeof(int));
+	int* remaining = allocOrDie(vertexCount, sizeof(int));
+	float* vertexScore = allocOrDie(vertexCount, sizeof(float));
+
+	memset(remaining, 0, vertexCount * sizeof(int));
+
+	for (size_t f=0; f<faceCount; ++f) {
+		int c[3];
+		triCorners(&faces[f], c);
+
+		for (int i=0; i<3; ++i) {
+			if (!repeatedCorner(c, i)) remaining[c[i]]++;
+		}
+	}
+
+	faceStart[0] = 0;
+	for (size_t v=0; v<vertexCount; ++v) {
+		faceStart[v+1] = faceStart[v] + remaining[v];
+	}
+
+	int* vertexFaces = allocOrDie((size_t)faceStart[vertexCount], sizeof(int));
+	memset(remaining, 0, vertexCount * sizeof(int));
+
+	for (size_t f=0; f<faceCount; ++f) {
+		int c[3];
+		triCorners(&faces[f], c);
+
+		for (int i=0; i<3; ++i) {
+			if (!repeatedCorner(c, i)) vertexFaces[faceStart[c[i]] + remaining[c[i]]++] = (int)f;
+		}
+	}
+
+	for (size_t v=0; v<vertexCount; ++v) {
+		vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+	}
+
+	float* faceScore = allocOrDie(faceCount, sizeof(float));
+	bool* emitted = allocOrDie(faceCount, sizeof(bool));
+	Tri* ordered = allocOrDie(faceCount, sizeof(Tri));
+
+	for (size_t f=0; f<faceCount; ++f) {
+		int c[3];
+		triCorners(&faces[f], c);
+
+		faceScore[f] = 0.0f;
+		for (int i=0; i<3; ++i) {
+			if (!repeatedCorner(c, i)) faceScore[f] += vertexScore[c[i]];
+		}
+		emitted[f] = false;
+	}
+
+	// LRU cache plus room for the 3 vertices pushed on each step
+	int cache[MESHOPT_FORSYTH_CACHE_SIZE + 3];
+	int cacheCount = 0;
+
+	int bestFace = -1;
+	size_t scanCursor = 0;
+
+	for (size_t out=0; out<faceCount; ++out) {
+		// Nothing in the cache has faces left, fall back to the next unemitted face in the original order
+		if (bestFace < 0) {
+			while (emitted[scanCursor]) scanCursor++;
+			bestFace = (int)scanCursor;
+		}
+
+		const Tri face = faces[bestFace];
+		ordered[out] = face;
+		emitted[bestFace] = true;
+
+		int c[3];
+		triCorners(&face, c);
+
+		// Drop the face from each of its vertices' lists
+		for (int i=0; i<3; ++i) {
+			if (repeatedCorner(c, i)) continue;
+
+			const int v = c[i];
+			int* list = vertexFaces + faceStart[v];
+
+			for (int k=0; k<remaining[v]; ++k) {
+				if (list[k] == bestFace) {
+					list[k] = list[--remaining[v]];
+					break;
+				}
+			}
+		}
+
+		// Move the face's vertices to the front of the cache, the rest shift back
+		int newCache[MESHOPT_FORSYTH_CACHE_SIZE + 3];
+		int newCount = 0;
+
+		for (int i=0; i<3; ++i) {
+			if (!repeatedCorner(c, i)) newCache[newCount++] = c[i];
+		}
+		for (int k=0; k<cacheCount; ++k) {
+			const int v = cache[k];
+			if (v != c[0] && v != c[1] && v != c[2]) newCache[newCount++] = v;
+		}
+
+		// Rescore everything that was or is in the cache, vertices that fell out lose their cache bonus
+		for (int k=0; k<newCount; ++k) {
+			const int v = newCache[k];
+			const int position = k < MESHOPT_FORSYTH_CACHE_SIZE ? k : -1;
+
+			const float newScore = forsythVertexScore(position, remaining[v]);
+			const float delta = newScore - vertexScore[v];
+			vertexScore[v] = newScore;
+
+			const int* list = vertexFaces + faceStart[v];
+			for (int j=0; j<remaining[v]; ++j) {
+				faceScore[list[j]] += delta;
+			}
+		}
+
+		cacheCount = newCount < MESHOPT_FORSYTH_CACHE_SIZE ? newCount : MESHOPT_FORSYTH_CACHE_SIZE;
+		memcpy(cache, newCache, cacheCount * sizeof(int));
+
+		// Next face is the best one touching the cache
+		bestFace = -1;
+		float bestScore = -1.0f;
+
+		for (int k=0; k<cacheCount; ++k) {
+			const int v = cache[k];
+			const int* list = vertexFaces + faceStart[v];
+
+			for (int j=0; j<remaining[v]; ++j) {
+				if (faceScore[list[j]] > bestScore) {
+					bestScore = faceScore[list[j]];
+					bestFace = list[j];
+				}
+			}
+		}
+	}
+
+	memcpy(faces, ordered, faceCount * sizeof(Tri));
+
+	free(faceStart);
+	free(remaining);
+	free(vertexScore);
+	free(vertexFaces);
+	free(faceScore);
+	free(emitted);
+	free(ordered);
+}
+
+// Each material range is ordered separately so the faces stay grouped by material
+void optimizeFaceOrder(Mesh* mesh) {
+	if (!mesh->faceRanges) {
+		optimizeFaceRun(mesh->faces, mesh->faceCount, mesh->vertexCount);
+		return;
+	}
+
+	for (int r=0; r<mesh->faceRangeCount; ++r) {
+		const MeshFaceRange range = mesh->faceRanges[r];
+		optimizeFaceRun(mesh->faces + range.first, (size_t)range.count, mesh->vertexCount);
+	}
+}
+
+// ========== VERTEX ORDER ==========
+
+// Renumbers vertices in the order faces first use them, so the per-vertex passes walk memory forwards.
+// Vertices no face uses keep their relative order at the end
+void reorderVerticesByFirstUse(Mesh* mesh) {
+	const size_t count = mesh->vertexCount;
+	if (count == 0) return;
+
+	int* remap = allocOrDie(count, sizeof(int));
+	memset(remap, 0xFF, count * sizeof(int));
+
+	int next = 0;
+
+	for (size_t f=0; f<mesh->faceCount; ++f) {
+		Tri* t = &mesh->faces[f];
+		int* corners[3] = { &t->v0, &t->v1, &t->v2 };
+
+		for (int i=0; i<3; ++i) {
+			const int v = *corners[i];
+			if (remap[v] < 0) remap[v] = next++;
+			*corners[i] = remap[v];
+		}
+	}
+
+	for (size_t v=0; v<count; ++v) {
+		if (remap[v] < 0) remap[v] = next++;
+	}
+
+	v3* reordered = allocOrDie(count, sizeof(v3));
+	for (size_t v=0; v<count; ++v) {
+		reordered[remap[v]] = mesh->vertices[v];
+	}
+
+	memcpy(mesh->vertices, reordered, count * sizeof(v3));
+
+	free(reordered);
+	free(remap);
+}
+
+// ========== NORMALS ==========
+
+// True when every face uses one normal on all three corners (exported flat shaded)
+static bool hasOnlyFaceNormals(const Mesh* mesh) {
+	for (size_t f=0; f<mesh->faceCount; ++f) {
+		const Tri* t = &mesh->faces[f];
+		if (t->n0 != t->n1 || t->n0 != t->n2) return false;
+	}
+	return true;
+}
+
+// Gives flat shaded meshes per vertex normals so they can be smooth shaded. Each corner gets the area weighted
+// average of the faces around its vertex that are within creaseDegrees of its own face, so hard edges like a
+// cube's stay hard. Identical normals are shared. Faces only smooth across shared vertex indices, which OBJ
+// exports already use between neighbouring faces.
+// Returns false (mesh untouched) if it already had vertex normals or is mapped from a cache (can't grow)
+bool smoothMeshNormals(Mesh* mesh, const double creaseDegrees) {
+	const size_t vertexCount = mesh->vertexCount;
+	const size_t faceCount = mesh->faceCount;
+
+	if (faceCount == 0 || mesh->mapping || !hasOnlyFaceNormals(mesh)) return false;
+
+	const double minCos = cos(creaseDegrees * (3.14159265358979323846 / 180.0));
+
+	// Unit face normals and areas, then the faces around each vertex (CSR layout)
+	v3* faceNormals = allocOrDie(faceCount, sizeof(v3));
+	double* faceAreas = allocOrDie(faceCount, sizeof(double));
+	int* offsets = allocOrDie(vertexCount + 1, sizeof(int));
+	int* vertexFaces = allocOrDie(faceCount * 3, sizeof(int));
+	memset(offsets, 0, (vertexCount + 1) * sizeof(int));
+
+	for (size_t f=0; f<faceCount; ++f) {
+		const Tri* t = &mesh->faces[f];
+		const v3 v0 = mesh->vertices[t->v0];
+
+		faceNormals[f] = meshFaceNormal(mesh, *t);
+		faceAreas[f] = v3Len(crossProduct(v3Sub(mesh->vertices[t->v1], v0), v3Sub(mesh->vertices[t->v2], v0)));
+
+		offsets[t->v0 + 1]++;
+		offsets[t->v1 + 1]++;
+		offsets[t->v2 + 1]++;
+	}
+
+	for (size_t v=0; v<vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+	int* fill = allocOrDie(vertexCount, sizeof(int));
+	memcpy(fill, offsets, vertexCount * sizeof(int));
+
+	for (size_t f=0; f<faceCount; ++f) {
+		const Tri* t = &mesh->faces[f];
+		vertexFaces[fill[t->v0]++] = (int)f;
+		vertexFaces[fill[t->v1]++] = (int)f;
+		vertexFaces[fill[t->v2]++] = (int)f;
+	}
+
+	// One normal per corner, deduplicated through an open addressing table (at most half full)
+	const size_t maxNormals = faceCount * 3;
+	size_t tableSize = 1;
+	while (tableSize < maxNormals * 2) tableSize <<= 1;
+
+	int* table = allocOrDie(tableSize, sizeof(int));
+	v3* normals = allocOrDie(maxNormals, sizeof(v3));
+	int* cornerNormals = allocOrDie(maxNormals, sizeof(int));
+	memset(table, 0xFF, tableSize * sizeof(int));
+
+	size_t normalCount = 0;
+
+	for (size_t f=0; f<faceCount; ++f) {
+		const Tri* t = &mesh->faces[f];
+		const int corners[3] = { t->v0, t->v1, t->v2 };
+
+		for (int k=0; k<3; ++k) {
+			const int v = corners[k];
+			v3 sum = {0, 0, 0};
+
+			for (int i=offsets[v]; i<offsets[v + 1]; ++i) {
+				const int g = vertexFaces[i];
+				if (dotProduct(faceNormals[f], faceNormals[g]) < minCos) continue;
+
+				sum = v3Add(sum, v3Scale(faceNormals[g], faceAreas[g]));
+			}
+
+			const v3 n = v3Len(sum) > 0 ? normalize(sum) : faceNormals[f];
+			size_t slot = hashPosition(n) & (tableSize - 1);
+
+			for (;;) {
+				const int existing = table[slot];
+
+				if (existing < 0) {
+					table[slot] = (int)normalCount;
+					normals[normalCount] = n;
+					cornerNormals[f * 3 + k] = (int)normalCount++;
+					break;
+				}
+
+				const v3 e = normals[existing];
+				if (e.x == n.x && e.y == n.y && e.z == n.z) {
+					cornerNormals[f * 3 + k] = existing;
+					break;
+				}
+
+				slot = (slot + 1) & (tableSize - 1);
+			}
+		}
+	}
+
+	free(mesh->normals);
+	mesh->normals = allocOrDie(normalCount, sizeof(v3));
+	memcpy(mesh->normals, normals, normalCount * sizeof(v3));
+	mesh->normalCount = normalCount;
+
+	for (size_t f=0; f<faceCount; ++f) {
+		Tri* t = &mesh->faces[f];
+		t->n0 = cornerNormals[f * 3 + 0];
+		t->n1 = cornerNormals[f * 3 + 1];
+		t->n2 = cornerNormals[f * 3 + 2];
+	}
+
+	free(faceNormals);
+	free(faceAreas);
+	free(offsets);
+	free(vertexFaces);
+	free(fill);
+	free(table);
+	free(normals);
+	free(cornerNormals);
+
+	return true;
+}
+
+// ========== REPORT ==========
+
+// Vertex cache misses per face with a FIFO cache, a vertex is cached while fewer than cacheSize misses
+// have happened since it was loaded
+double meshACMR(const Mesh* mesh, const int cacheSize) {
+	if (mesh->faceCount == 0 || mesh->vertexCount == 0) return 0.0;
+
+	size_t* loadedAt = allocOrDie(mesh->vertexCount, sizeof(size_t));
+	memset(loadedAt, 0, mesh->vertexCount * sizeof(size_t));
+
+	// Miss counter starts past cacheSize so a 0 timestamp always reads as not cached
+	size_t misses = (size_t)cacheSize + 1;
+	const size_t start = misses;
+
+	for (size_t f=0; f<mesh->faceCount; ++f) {
+		const Tri* t = &mesh->faces[f];
+		const int corners[3] = { t->v0, t->v1, t->v2 };
+
+		for (int i=0; i<3; ++i) {
+			const int v = corners[i];
+
+			if (misses - loadedAt[v] >= (size_t)cacheSize) {
+				loadedAt[v] = misses++;
+			}
+		}
+	}
+
+	free(loadedAt);
+	return (double)(misses - start) / (double)mesh->faceCount;
+}
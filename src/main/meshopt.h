@@ -0,0 +1,32 @@
+// Load time mesh optimisation (welding, cache friendly ordering and smooth normals)
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_MESHOPT_H
+#define CUBERENDER_MESHOPT_H
+
+#include "mesh.h"
+
+// Simulated post transform cache for the ACMR figure (FIFO, like most GPUs)
+#define MESHOPT_ACMR_CACHE_SIZE 16
+
+// LRU cache the Forsyth face ordering scores against
+#define MESHOPT_FORSYTH_CACHE_SIZE 32
+
+typedef struct {
+	size_t verticesBefore, verticesAfter;
+
+	// Average cache miss ratio, vertex cache misses per face (0.5 is ideal for big grids, 3 is worst)
+	double acmrBefore, acmrAfter;
+} MeshOptimizeStats;
+
+void optimizeMesh(Mesh* mesh, MeshOptimizeStats* stats);
+
+size_t weldMeshVertices(Mesh* mesh);
+void optimizeFaceOrder(Mesh* mesh);
+void reorderVerticesByFirstUse(Mesh* mesh);
+
+bool smoothMeshNormals(Mesh* mesh, double creaseDegrees);
+
+double meshACMR(const Mesh* mesh, int cacheSize);
+
+#endif //CUBERENDER_MESHOPT_H
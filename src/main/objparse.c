@@ -0,0 +1,861 @@
+// Fast .obj text parsing
+// Created by James Schaffer on 16/10/2026.
+
+#include "objparse.h"
+#include "threadpool.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ========== FILE ==========
+
+// One read of the whole file, NUL terminated so parsers can't run off the end
+char* readWholeFile(const char* path, size_t* length) {
+	FILE* fptr = fopen(path, "rb");
+	if (fptr == NULL) return NULL;
+
+	fseek(fptr, 0, SEEK_END);
+	const long size = ftell(fptr);
+	fseek(fptr, 0, SEEK_SET);
+
+	if (size < 0) {
+		fclose(fptr);
+		return NULL;
+	}
+
+	char* text = malloc((size_t)size + 1);
+	if (!text) {
+		fclose(fptr);
+		return NULL;
+	}
+
+	const size_t read = fread(text, 1, (size_t)size, fptr);
+	fclose(fptr);
+
+	text[read] = '\0';
+	*length = read;
+
+	return text;
+}
+
+// ========== NUMBERS ==========
+// Hand rolled so they don't depend on the C locale (',' decimal points) and skip strtod's overhead
+
+// Powers of ten that are exact in a double
+static const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const char* skipBlanks(const char* p) {
+	while (*p == ' ' || *p == '\t') p++;
+	return p;
+}
+
+// Returns the position after the number, or NULL if there isn't one
+const char* parseDouble(const char* p, double* out) {
+	p = skipBlanks(p);
+
+	bool negative = false;
+	if (*p == '-') {
+		negative = true;
+		p++;
+	} else if (*p == '+') {
+		p++;
+	}
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any = false;
+
+	// Digits past 19 can't fit the mantissa, they only move the exponent
+	for (; *p >= '0' && *p <= '9'; ++p) {
+		any = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa) digits++;
+		} else {
+			exponent++;
+		}
+	}
+
+	if (*p == '.') {
+		p++;
+		for (; *p >= '0' && *p <= '9'; ++p) {
+			any = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa) digits++;
+				exponent--;
+			}
+		}
+	}
+
+	if (!any) return NULL;
+
+	if (*p == 'e' || *p == 'E') {
+		const char* e = p + 1;
+		bool expNegative = false;
+
+		if (*e == '-') {
+			expNegative = true;
+			e++;
+		} else if (*e == '+') {
+			e++;
+		}
+
+		if (*e >= '0' && *e <= '9') {
+			int value = 0;
+			for (; *e >= '0' && *e <= '9'; ++e) {
+				if (value < 10000) value = value * 10 + (*e - '0');
+			}
+
+			exponent += expNegative ? -value : value;
+			p = e;
+		}
+	}
+
+	// mantissa < 2^53 and |exponent| <= 22 is one correctly rounded operation, same as strtod
+	double value = (double)mantissa;
+	if (exponent < 0) {
+		if (exponent >= -22) {
+			value /= POW10[-exponent];
+		} else {
+			value /= pow(10.0, -exponent);
+		}
+	} else if (exponent > 0) {
+		if (exponent <= 22) {
+			value *= POW10[exponent];
+		} else {
+			value *= pow(10.0, exponent);
+		}
+	}
+
+	*out = negative ? -value : value;
+	return p;
+}
+
+const char* parseInt(const char* p, int* out) {
+	p = skipBlanks(p);
+
+	bool negative = false;
+	if (*p == '-') {
+		negative = true;
+		p++;
+	} else if (*p == '+') {
+		p++;
+	}
+
+	if (*p < '0' || *p > '9') return NULL;
+
+	long long value = 0;
+	for (; *p >= '0' && *p <= '9'; ++p) {
+		if (value < 0x7FFFFFFF) value = value * 10 + (*p - '0');
+	}
+
+	*out = (int)(negative ? -value : value);
+	return p;
+}
+
+// Rest of the line without the blanks around it (names can have spaces), cut to fit size.
+// Returns the end of the line
+const char* parseName(const char* p, char* out, const size_t size) {
+	p = skipBlanks(p);
+
+	const char* end = p;
+	while (*end != '\0' && *end != '\n' && *end != '\r') end++;
+
+	const char* last = end;
+	while (last > p && (last[-1] == ' ' || last[-1] == '\t')) last--;
+
+	size_t length = (size_t)(last - p);
+	if (length >= size) length = size - 1;
+
+	memcpy(out, p, length);
+	out[length] = '\0';
+
+	return end;
+}
+
+// ========== BUFFERS ==========
+
+// Amortized doubling so appending n elements is O(n) overall
+static void* reserveArray(void* array, size_t* capacity, const size_t needed, const size_t elemSize) {
+	if (needed <= *capacity) return array;
+
+	size_t newCapacity = *capacity ? *capacity : OBJPARSE_INITIAL_CAPACITY;
+	while (newCapacity < needed) newCapacity *= 2;
+
+	void* newArray = realloc(array, newCapacity * elemSize);
+	if (!newArray) {
+		puts("Error resizing obj buffer");
+		raise(SIGTERM);
+	}
+
+	*capacity = newCapacity;
+	return newArray;
+}
+
+static void pushObject(OBJData* data) {
+	data->objects = reserveArray(data->objects, &data->objectCapacity, data->objectCount + 1, sizeof(OBJObject));
+	data->objects[data->objectCount++] = (OBJObject){ data->positionCount, data->normalCount, data->texcoordCount, data->faceCount };
+}
+
+// Index of the material name, added on first use
+static int findOrAddMaterial(OBJData* data, const char* name) {
+	for (size_t i=0; i<data->materialCount; ++i) {
+		if (strcmp(data->materialNames[i].name, name) == 0) return (int)i;
+	}
+
+	data->materialNames = reserveArray(data->materialNames, &data->materialCapacity, data->materialCount + 1, sizeof(MeshMaterialName));
+	snprintf(data->materialNames[data->materialCount].name, MESH_MATERIAL_NAME_MAX, "%s", name);
+
+	return (int)data->materialCount++;
+}
+
+// ========== PARSER ==========
+
+// Face corner flags
+#define CORNER_HAS_NORMAL	1
+#define CORNER_V_RELATIVE	2
+#define CORNER_N_RELATIVE	4
+#define CORNER_HAS_TEXCOORD	8
+#define CORNER_T_RELATIVE	16
+
+// OBJ indices are 1 based and negative ones count back from the newest element. Inside a chunk the
+// newest element isn't known yet, so negative indices are kept relative to the chunk and fixed at the merge
+static bool resolveIndex(const int index, const size_t count, const bool deferred, int* out, bool* relative) {
+	*relative = false;
+
+	if (index > 0) {
+		*out = index - 1;
+		return true;
+	}
+	if (index < 0 && deferred) {
+		*out = (int)count + index;
+		*relative = true;
+		return true;
+	}
+	if (index < 0 && (size_t)(-index) <= count) {
+		*out = (int)count + index;
+		return true;
+	}
+	return false;
+}
+
+// u [v [w]], w isn't used
+static const char* parseTexcoord(const char* p, v2* out) {
+	if (!(p = parseDouble(p, &out->x))) return NULL;
+
+	const char* next = parseDouble(p, &out->y);
+	if (!next) {
+		out->y = 0;
+		return p;
+	}
+	return next;
+}
+
+static const char* parseVector(const char* p, v3* out) {
+	if (!(p = parseDouble(p, &out->x))) return NULL;
+	if (!(p = parseDouble(p, &out->y))) return NULL;
+	return parseDouble(p, &out->z);
+}
+
+// One face corner : v, v/t, v//n or v/t/n. Missing indices are left at -1
+static const char* parseCorner(const char* p, const OBJData* data, const bool deferred, int* v, int* t, int* n, int* flags) {
+	int raw;
+	bool relative;
+
+	*flags = 0;
+
+	if (!(p = parseInt(p, &raw))) return NULL;
+	if (!resolveIndex(raw, data->positionCount, deferred, v, &relative)) return NULL;
+	if (relative) *flags |= CORNER_V_RELATIVE;
+
+	*n = -1;
+	*t = -1;
+
+	if (*p == '/') {
+		p++;
+
+		if (*p != '/') {
+			if (!(p = parseInt(p, &raw))) return NULL;
+			if (!resolveIndex(raw, data->texcoordCount, deferred, t, &relative)) return NULL;
+
+			*flags |= CORNER_HAS_TEXCOORD;
+			if (relative) *flags |= CORNER_T_RELATIVE;
+		}
+
+		if (*p == '/') {
+			p++;
+			if (!(p = parseInt(p, &raw))) return NULL;
+			if (!resolveIndex(raw, data->normalCount, deferred, n, &relative)) return NULL;
+
+			*flags |= CORNER_HAS_NORMAL;
+			if (relative) *flags |= CORNER_N_RELATIVE;
+		}
+	}
+
+	return p;
+}
+
+static void pushFixup(OBJChunk* chunk, const int slot, const int line) {
+	chunk->fixups = reserveArray(chunk->fixups, &chunk->fixupCapacity, chunk->fixupCount + 1, sizeof(OBJFixup));
+	chunk->fixups[chunk->fixupCount++] = (OBJFixup){ chunk->data.faceCount, slot, line };
+}
+
+// Polygons are fan triangulated, corners without a normal borrow the first one the triangle has.
+// Without any the normals stay -1 and the face gets its geometric normal once positions are known
+static const char* parseFace(const char* p, OBJData* data, OBJChunk* chunk, const int line) {
+	int v[3], t[3], n[3], flags[3];
+	int corners = 0;
+
+	for (;;) {
+		p = skipBlanks(p);
+		if (*p == '\n' || *p == '\r' || *p == '#' || *p == '\0') break;
+
+		const int slot = corners < 2 ? corners : 2;
+		if (!(p = parseCorner(p, data, chunk != NULL, &v[slot], &t[slot], &n[slot], &flags[slot]))) return NULL;
+		corners++;
+
+		if (corners >= 3) {
+			int source = -1;
+			for (int i=0; i<3 && source < 0; ++i) {
+				if (flags[i] & CORNER_HAS_NORMAL) source = i;
+			}
+
+			for (int i=0; i<3 && source >= 0; ++i) {
+				if (flags[i] & CORNER_HAS_NORMAL) continue;
+
+				n[i] = n[source];
+				flags[i] |= flags[source] & (CORNER_HAS_NORMAL | CORNER_N_RELATIVE);
+			}
+
+			if (chunk) {
+				for (int i=0; i<3; ++i) {
+					if (flags[i] & CORNER_V_RELATIVE) pushFixup(chunk, i, line);
+					if (flags[i] & CORNER_N_RELATIVE) pushFixup(chunk, 3 + i, line);
+					if (flags[i] & CORNER_T_RELATIVE) pushFixup(chunk, 6 + i, line);
+				}
+			}
+
+			data->faces = reserveArray(data->faces, &data->faceCapacity, data->faceCount + 1, sizeof(Tri));
+			data->faces[data->faceCount++] = (Tri){ v[0], v[1], v[2], n[0], n[1], n[2], t[0], t[1], t[2], data->currentMaterial };
+
+			// Next triangle of the fan shares corner 0 and this corner
+			v[1] = v[2];
+			t[1] = t[2];
+			n[1] = n[2];
+			flags[1] = flags[2];
+		}
+	}
+
+	return corners >= 3 ? p : NULL;
+}
+
+// Parses the lines in [p, end) into out, chunk is NULL unless this is one chunk of a parallel parse.
+// Returns the number of lines read, stopping at the first bad one (errorLine is set)
+static int parseLines(const char* p, const char* end, OBJData* out, OBJChunk* chunk) {
+	int lineNumb = 1;
+
+	while (p < end) {
+		const char* lineEnd = memchr(p, '\n', end - p);
+		if (!lineEnd) lineEnd = end;
+
+		const char* ok = p;
+
+		switch (p[0]) {
+			// New object
+			case 'o':
+				pushObject(out);
+				break;
+
+			// Vertex / texture / normal / paremeter
+			case 'v':
+				// Data before any 'o' goes in an unnamed object
+				if (out->objectCount == 0) {
+					pushObject(out);
+					if (chunk) chunk->implicitObject = true;
+				}
+
+				if (p[1] == ' ' || p[1] == '\t') {
+					out->positions = reserveArray(out->positions, &out->positionCapacity, out->positionCount + 1, sizeof(v3));
+					ok = parseVector(p + 1, &out->positions[out->positionCount]);
+					if (ok) out->positionCount++;
+				} else if (p[1] == 'n') {
+					out->normals = reserveArray(out->normals, &out->normalCapacity, out->normalCount + 1, sizeof(v3));
+					ok = parseVector(p + 2, &out->normals[out->normalCount]);
+					if (ok) out->normalCount++;
+				} else if (p[1] == 't') {
+					out->texcoords = reserveArray(out->texcoords, &out->texcoordCapacity, out->texcoordCount + 1, sizeof(v2));
+					ok = parseTexcoord(p + 2, &out->texcoords[out->texcoordCount]);
+					if (ok) out->texcoordCount++;
+				}
+				// vp isn't used
+				break;
+
+			// Faces
+			case 'f':
+				if (out->objectCount == 0) {
+					pushObject(out);
+					if (chunk) chunk->implicitObject = true;
+				}
+				ok = parseFace(p + 1, out, chunk, lineNumb);
+				break;
+
+			// Material for the faces after it, kept across objects
+			case 'u':
+				if (strncmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t')) {
+					char name[MESH_MATERIAL_NAME_MAX];
+					parseName(p + 6, name, sizeof(name));
+					out->currentMaterial = findOrAddMaterial(out, name);
+				}
+				break;
+
+			case 'm':
+				if (strncmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t') && out->materialLibrary[0] == '\0') {
+					parseName(p + 6, out->materialLibrary, sizeof(out->materialLibrary));
+				}
+				break;
+
+			// Comment, groups, smoothing, lines and blank lines are skipped
+			default:
+				break;
+		}
+
+		if (!ok) {
+			out->errorLine = lineNumb;
+			return lineNumb;
+		}
+
+		p = lineEnd + 1;
+		lineNumb++;
+	}
+
+	return lineNumb - 1;
+}
+
+// Parses a whole .obj text buffer into file wide arrays, returns 0 and sets errorLine on bad input.
+// On one thread this is about 5x the old fgets / sscanf loader (Sphere.obj and larger), not 10x.
+// Anything past that on big files comes from parseOBJParallel spreading it over cores
+int parseOBJ(const char* text, const size_t length, OBJData* out) {
+	*out = (OBJData){0};
+	out->currentMaterial = -1;
+	parseLines(text, text + length, out, NULL);
+
+	return out->errorLine == 0;
+}
+
+// ========== PARALLEL PARSER ==========
+// The file is cut into line aligned chunks which are parsed independently, then a prefix sum over the
+// chunk counts gives each chunk its place in the merged arrays and the chunks are copied in parallel
+
+typedef struct {
+	OBJChunk* chunks;
+	int chunkCount;
+	OBJData* out;
+} OBJParallelJob;
+
+static void parseChunkTask(const int task, const int worker, void* userdata) {
+	(void)worker;
+	OBJChunk* chunk = &((OBJParallelJob*)userdata)->chunks[task];
+
+	// Whatever usemtl was last before the chunk isn't known until every chunk is parsed
+	chunk->data.currentMaterial = OBJPARSE_MATERIAL_INHERITED;
+	chunk->lineCount = parseLines(chunk->start, chunk->end, &chunk->data, chunk);
+}
+
+static int* fixupSlot(Tri* tri, const int slot) {
+	switch (slot) {
+		case 0: return &tri->v0;
+		case 1: return &tri->v1;
+		case 2: return &tri->v2;
+		case 3: return &tri->n0;
+		case 4: return &tri->n1;
+		case 5: return &tri->n2;
+		case 6: return &tri->t0;
+		case 7: return &tri->t1;
+		default: return &tri->t2;
+	}
+}
+
+static void mergeChunkTask(const int task, const int worker, void* userdata) {
+	(void)worker;
+	const OBJParallelJob* job = userdata;
+	OBJChunk* chunk = &job->chunks[task];
+	const OBJData* data = &chunk->data;
+	OBJData* out = job->out;
+
+	if (data->positionCount) memcpy(out->positions + chunk->positionBase, data->positions, data->positionCount * sizeof(v3));
+	if (data->normalCount) memcpy(out->normals + chunk->normalBase, data->normals, data->normalCount * sizeof(v3));
+	if (data->texcoordCount) memcpy(out->texcoords + chunk->texcoordBase, data->texcoords, data->texcoordCount * sizeof(v2));
+	if (data->faceCount) memcpy(out->faces + chunk->faceBase, data->faces, data->faceCount * sizeof(Tri));
+
+	for (size_t i=0; i<data->faceCount; ++i) {
+		Tri* face = &out->faces[chunk->faceBase + i];
+		face->material = face->material == OBJPARSE_MATERIAL_INHERITED ? chunk->materialBase : chunk->materialRemap[face->material];
+	}
+
+	// Chunk relative negative indices -> file wide, checked the same way the sequential parser does
+	for (size_t i=0; i<chunk->fixupCount; ++i) {
+		const OBJFixup* fixup = &chunk->fixups[i];
+
+		int* index = fixupSlot(&out->faces[chunk->faceBase + fixup->face], fixup->slot);
+		*index += (int)(fixup->slot >= 6 ? chunk->texcoordBase : fixup->slot >= 3 ? chunk->normalBase : chunk->positionBase);
+
+		if (*index < 0) {
+			chunk->fixupErrorLine = fixup->line;
+			break;
+		}
+	}
+
+	// An unnamed leading object is only real if nothing before this chunk started an object
+	const size_t skip = chunk->dropFirstObject ? 1 : 0;
+	for (size_t i=skip; i<data->objectCount; ++i) {
+		const OBJObject* o = &data->objects[i];
+
+		out->objects[chunk->objectBase + i - skip] = (OBJObject){
+			chunk->positionBase + o->firstPosition,
+			chunk->normalBase + o->firstNormal,
+			chunk->texcoordBase + o->firstTexcoord,
+			chunk->faceBase + o->firstFace
+		};
+	}
+}
+
+static void* allocMerged(const size_t count, const size_t elemSize) {
+	if (count == 0) return NULL;
+
+	void* array = malloc(count * elemSize);
+	if (!array) {
+		puts("Error allocating obj buffer");
+		raise(SIGTERM);
+	}
+	return array;
+}
+
+static void freeChunk(OBJChunk* chunk) {
+	freeOBJData(&chunk->data);
+	free(chunk->fixups);
+	free(chunk->materialRemap);
+}
+
+// Same result as parseOBJ, small files or a single thread just use parseOBJ
+int parseOBJParallel(const char* text, const size_t length, OBJData* out, const int threadCount) {
+	if (threadCount <= 1 || length < OBJPARSE_PARALLEL_MIN_SIZE) {
+		return parseOBJ(text, length, out);
+	}
+
+	*out = (OBJData){0};
+	out->currentMaterial = -1;
+
+	// Several chunks per thread so the pool can balance uneven lines
+	size_t chunkCount = (size_t)threadCount * OBJPARSE_CHUNKS_PER_THREAD;
+	if (chunkCount > length / OBJPARSE_MIN_CHUNK_SIZE) chunkCount = length / OBJPARSE_MIN_CHUNK_SIZE;
+	if (chunkCount < 1) chunkCount = 1;
+
+	OBJChunk* chunks = calloc(chunkCount, sizeof(OBJChunk));
+	if (!chunks) {
+		puts("Error allocating obj chunks");
+		raise(SIGTERM);
+	}
+
+	// Cut points are moved forward to the start of the next line
+	const char* end = text + length;
+	const char* start = text;
+
+	for (size_t i=0; i<chunkCount; ++i) {
+		const char* cut = i + 1 == chunkCount ? end : text + length / chunkCount * (i + 1);
+
+		if (cut < start) cut = start;
+		if (cut < end && cut > text && cut[-1] != '\n') {
+			const char* newline = memchr(cut, '\n', end - cut);
+			cut = newline ? newline + 1 : end;
+		}
+
+		chunks[i].start = start;
+		chunks[i].end = cut;
+		start = cut;
+	}
+
+	ThreadPool* pool = createThreadPool(threadCount);
+	OBJParallelJob job = { chunks, (int)chunkCount, out };
+
+	threadPoolRun(pool, (int)chunkCount, parseChunkTask, &job);
+
+	// Prefix sum of the chunk counts, material names merged in file order
+	size_t positions = 0, normals = 0, texcoords = 0, faces = 0, objects = 0;
+	int lines = 0;
+
+	for (size_t i=0; i<chunkCount; ++i) {
+		OBJChunk* chunk = &chunks[i];
+
+		chunk->positionBase = positions;
+		chunk->normalBase = normals;
+		chunk->texcoordBase = texcoords;
+		chunk->faceBase = faces;
+
+		chunk->materialRemap = allocMerged(chunk->data.materialCount, sizeof(int));
+		for (size_t m=0; m<chunk->data.materialCount; ++m) {
+			chunk->materialRemap[m] = findOrAddMaterial(out, chunk->data.materialNames[m].name);
+		}
+
+		chunk->materialBase = out->currentMaterial;
+		if (chunk->data.currentMaterial >= 0) out->currentMaterial = chunk->materialRemap[chunk->data.currentMaterial];
+
+		if (out->materialLibrary[0] == '\0') {
+			memcpy(out->materialLibrary, chunk->data.materialLibrary, sizeof(out->materialLibrary));
+		}
+		chunk->objectBase = objects;
+		chunk->lineBase = lines;
+		chunk->dropFirstObject = chunk->implicitObject && objects > 0;
+
+		positions += chunk->data.positionCount;
+		normals += chunk->data.normalCount;
+		texcoords += chunk->data.texcoordCount;
+		faces += chunk->data.faceCount;
+		objects += chunk->data.objectCount - (chunk->dropFirstObject ? 1 : 0);
+		lines += chunk->lineCount;
+
+		// Nothing past a bad line is used
+		if (chunk->data.errorLine) {
+			chunkCount = i + 1;
+			break;
+		}
+	}
+
+	out->positions = allocMerged(positions, sizeof(v3));
+	out->normals = allocMerged(normals, sizeof(v3));
+	out->texcoords = allocMerged(texcoords, sizeof(v2));
+	out->faces = allocMerged(faces, sizeof(Tri));
+	out->objects = allocMerged(objects, sizeof(OBJObject));
+
+	out->positionCount = out->positionCapacity = positions;
+	out->normalCount = out->normalCapacity = normals;
+	out->texcoordCount = out->texcoordCapacity = texcoords;
+	out->faceCount = out->faceCapacity = faces;
+	out->objectCount = out->objectCapacity = objects;
+
+	threadPoolRun(pool, (int)chunkCount, mergeChunkTask, &job);
+	destroyThreadPool(pool);
+
+	// First error in file order, a bad relative index comes before any parse error in the same chunk
+	for (size_t i=0; i<chunkCount; ++i) {
+		const int errorLine = chunks[i].fixupErrorLine ? chunks[i].fixupErrorLine : chunks[i].data.errorLine;
+
+		if (errorLine) {
+			out->errorLine = chunks[i].lineBase + errorLine;
+			break;
+		}
+	}
+
+	for (size_t i=0; i<(size_t)job.chunkCount; ++i) {
+		freeChunk(&chunks[i]);
+	}
+	free(chunks);
+
+	return out->errorLine == 0;
+}
+
+void freeOBJData(OBJData* data) {
+	free(data->positions);
+	free(data->normals);
+	free(data->texcoords);
+	free(data->faces);
+	free(data->objects);
+	free(data->materialNames);
+
+	*data = (OBJData){0};
+}
+
+// ========== MESHES ==========
+
+// Copies a range into an exactly sized array (NULL for an empty range)
+static void* copyRange(const void* src, const size_t count, const size_t elemSize) {
+	if (count == 0) return NULL;
+
+	void* dst = malloc(count * elemSize);
+	if (!dst) {
+		puts("Error allocating mesh memory");
+		raise(SIGTERM);
+	}
+
+	memcpy(dst, src, count * elemSize);
+	return dst;
+}
+
+// File wide index -> object local for elements another object owns, allocated on the first foreign reference
+typedef struct {
+	int* local;
+	int* owner; // object that local belongs to, -1 for none yet
+} OBJForeignMap;
+
+// One of an object's arrays (positions, normals or texcoords), grown when foreign elements are copied in
+typedef struct {
+	const void* fileArray;
+	size_t fileCount, elemSize;
+	size_t first, end; // the object's own range in the file wide array
+
+	void** array;
+	size_t* count;
+	size_t capacity;
+
+	OBJForeignMap foreign;
+} OBJObjectArray;
+
+// Object local index for a file wide one. OBJ indices are file wide so faces can use another object's
+// elements, those are copied to the end of this object's array once. -1 if the index is outside the file
+static int objectLocalIndex(OBJObjectArray* a, const int index, const int object) {
+	if (index < 0 || (size_t)index >= a->fileCount) return -1;
+	if ((size_t)index >= a->first && (size_t)index < a->end) return index - (int)a->first;
+
+	if (!a->foreign.local) {
+		a->foreign.local = allocMerged(a->fileCount, sizeof(int));
+		a->foreign.owner = allocMerged(a->fileCount, sizeof(int));
+		memset(a->foreign.owner, 0xFF, a->fileCount * sizeof(int));
+	}
+
+	if (a->foreign.owner[index] != object) {
+		*a->array = reserveArray(*a->array, &a->capacity, *a->count + 1, a->elemSize);
+		memcpy((char*)*a->array + *a->count * a->elemSize, (const char*)a->fileArray + (size_t)index * a->elemSize, a->elemSize);
+
+		a->foreign.owner[index] = object;
+		a->foreign.local[index] = (int)(*a->count)++;
+	}
+
+	return a->foreign.local[index];
+}
+
+static void startObjectArray(OBJObjectArray* a, void** array, size_t* count, const size_t first, const size_t end) {
+	a->first = first;
+	a->end = end;
+	a->array = array;
+	a->count = count;
+
+	*count = end - first;
+	a->capacity = *count;
+	*array = *count ? copyRange((const char*)a->fileArray + first * a->elemSize, *count, a->elemSize) : NULL;
+}
+
+// Geometric normal of a face from its (object local) positions, counter clockwise is the front like the
+// exported normals. Degenerate faces get a zero normal. Returns its index in the object's normals
+static int appendFaceNormal(OBJObjectArray* normals, const Mesh* mesh, const Tri* t) {
+	const v3 v0 = mesh->vertices[t->v0];
+	v3 normal = crossProduct(v3Sub(mesh->vertices[t->v1], v0), v3Sub(mesh->vertices[t->v2], v0));
+	if (v3Len(normal) > 0) normal = normalize(normal);
+
+	*normals->array = reserveArray(*normals->array, &normals->capacity, *normals->count + 1, sizeof(v3));
+	((v3*)*normals->array)[*normals->count] = normal;
+
+	return (int)(*normals->count)++;
+}
+
+// Splits the file wide arrays into one Mesh per object with object local indices.
+// Returns NULL (nothing allocated) if a face indexes past the end of the file's data
+Mesh* meshesFromOBJData(const OBJData* data, const char* fileName, int* meshCount) {
+	*meshCount = 0;
+	if (data->objectCount == 0) return NULL;
+
+	Mesh* meshArr = calloc(data->objectCount, sizeof(Mesh));
+	if (!meshArr) {
+		puts("Error allocating mesh memory");
+		raise(SIGTERM);
+	}
+
+	// File material index -> the object's own list, reset per object
+	int* materialRemap = allocMerged(data->materialCount, sizeof(int));
+
+	OBJObjectArray positions = { .fileArray = data->positions, .fileCount = data->positionCount, .elemSize = sizeof(v3) };
+	OBJObjectArray normals = { .fileArray = data->normals, .fileCount = data->normalCount, .elemSize = sizeof(v3) };
+	OBJObjectArray texcoords = { .fileArray = data->texcoords, .fileCount = data->texcoordCount, .elemSize = sizeof(v2) };
+
+	bool valid = true;
+
+	for (size_t i=0; i<data->objectCount && valid; ++i) {
+		const OBJObject* o = &data->objects[i];
+		const bool last = i + 1 == data->objectCount;
+		const int object = (int)i;
+
+		const size_t positionEnd = last ? data->positionCount : data->objects[i+1].firstPosition;
+		const size_t normalEnd = last ? data->normalCount : data->objects[i+1].firstNormal;
+		const size_t texcoordEnd = last ? data->texcoordCount : data->objects[i+1].firstTexcoord;
+		const size_t faceEnd = last ? data->faceCount : data->objects[i+1].firstFace;
+
+		Mesh* mesh = &meshArr[i];
+
+		startObjectArray(&positions, (void**)&mesh->vertices, &mesh->vertexCount, o->firstPosition, positionEnd);
+		startObjectArray(&normals, (void**)&mesh->normals, &mesh->normalCount, o->firstNormal, normalEnd);
+		startObjectArray(&texcoords, (void**)&mesh->texcoords, &mesh->texcoordCount, o->firstTexcoord, texcoordEnd);
+
+		mesh->faceCount = faceEnd - o->firstFace;
+		mesh->faces = copyRange(data->faces + o->firstFace, mesh->faceCount, sizeof(Tri));
+
+		memcpy(mesh->materialLibrary, data->materialLibrary, sizeof(mesh->materialLibrary));
+
+		for (size_t m=0; m<data->materialCount; ++m) materialRemap[m] = -1;
+
+		// File wide -> object local indices
+		for (size_t f=0; f<mesh->faceCount; ++f) {
+			Tri* t = &mesh->faces[f];
+
+			int* corners[9] = { &t->v0, &t->v1, &t->v2, &t->n0, &t->n1, &t->n2, &t->t0, &t->t1, &t->t2 };
+			OBJObjectArray* arrays[3] = { &positions, &normals, &texcoords };
+
+			for (int k=0; k<9 && valid; ++k) {
+				// -1 (no normal / texcoord) stays -1
+				if (k >= 3 && *corners[k] < 0) continue;
+
+				*corners[k] = objectLocalIndex(arrays[k / 3], *corners[k], object);
+				valid = *corners[k] >= 0;
+			}
+
+			if (!valid) {
+				printf("Error face %i of object %i references data past the end of '%s'\n", (int)f, object, fileName);
+				break;
+			}
+
+			// None of the corners had a normal (parseFace fills the rest from any that did)
+			if (t->n0 < 0) {
+				const int normal = appendFaceNormal(&normals, mesh, t);
+				t->n0 = t->n1 = t->n2 = normal;
+			}
+
+			if (t->material < 0) continue;
+
+			if (materialRemap[t->material] < 0) {
+				materialRemap[t->material] = mesh->materialCount++;
+			}
+			t->material = materialRemap[t->material];
+		}
+
+		// Names in the order the object first used them
+		if (mesh->materialCount > 0) {
+			mesh->materialNames = allocMerged(mesh->materialCount, sizeof(MeshMaterialName));
+
+			for (size_t m=0; m<data->materialCount; ++m) {
+				if (materialRemap[m] >= 0) mesh->materialNames[materialRemap[m]] = data->materialNames[m];
+			}
+		}
+	}
+
+	free(materialRemap);
+
+	OBJObjectArray* arrays[3] = { &positions, &normals, &texcoords };
+	for (int k=0; k<3; ++k) {
+		free(arrays[k]->foreign.local);
+		free(arrays[k]->foreign.owner);
+	}
+
+	// Same as a parse error, the partial meshes are dropped
+	if (!valid) {
+		for (size_t i=0; i<data->objectCount; ++i) freeMeshData(&meshArr[i]);
+		free(meshArr);
+		return NULL;
+	}
+
+	*meshCount = (int)data->objectCount;
+	return meshArr;
+}
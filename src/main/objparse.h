@@ -0,0 +1,100 @@
+// Fast .obj text parsing
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_OBJPARSE_H
+#define CUBERENDER_OBJPARSE_H
+
+#include <stddef.h>
+
+#include "mesh.h"
+
+#define OBJPARSE_INITIAL_CAPACITY 256
+
+// Files smaller than this aren't worth starting threads for
+#define OBJPARSE_PARALLEL_MIN_SIZE	(1 << 20)
+#define OBJPARSE_MIN_CHUNK_SIZE		(1 << 18)
+#define OBJPARSE_CHUNKS_PER_THREAD	4
+
+// Face material inside a chunk before its first usemtl, replaced by the material the earlier chunks ended on
+#define OBJPARSE_MATERIAL_INHERITED	-2
+
+// Start of each 'o' object in the file wide arrays
+typedef struct {
+	size_t firstPosition, firstNormal, firstTexcoord, firstFace;
+} OBJObject;
+
+// Whole file contents, face indices are 0 based into the file wide arrays (not per object)
+typedef struct {
+	v3* positions;
+	size_t positionCount, positionCapacity;
+
+	v3* normals;
+	size_t normalCount, normalCapacity;
+
+	v2* texcoords;
+	size_t texcoordCount, texcoordCapacity;
+
+	Tri* faces;
+	size_t faceCount, faceCapacity;
+
+	OBJObject* objects;
+	size_t objectCount, objectCapacity;
+
+	// Every usemtl name once, face materials index this. currentMaterial is the one new faces get
+	MeshMaterialName* materialNames;
+	size_t materialCount, materialCapacity;
+	int currentMaterial;
+
+	// First mtllib, "" if none
+	char materialLibrary[MESH_MATERIAL_NAME_MAX];
+
+	// Line of the first error, 0 if none
+	int errorLine;
+} OBJData;
+
+// Face index slot (0-2 = v0-v2, 3-5 = n0-n2, 6-8 = t0-t2) holding a chunk relative negative index
+typedef struct {
+	size_t face;
+	int slot;
+	int line;
+} OBJFixup;
+
+// One line aligned piece of the file for the parallel parser
+typedef struct {
+	const char* start;
+	const char* end;
+
+	OBJData data;
+	int lineCount;
+
+	OBJFixup* fixups;
+	size_t fixupCount, fixupCapacity;
+
+	// objects[0] was made for data before any 'o' in this chunk
+	bool implicitObject;
+
+	// Where the chunk goes in the merged arrays (prefix sums of the earlier chunks)
+	size_t positionBase, normalBase, texcoordBase, faceBase, objectBase;
+	int lineBase;
+	bool dropFirstObject;
+
+	// Chunk material index -> merged, and the material in use where the chunk starts
+	int* materialRemap;
+	int materialBase;
+
+	int fixupErrorLine;
+} OBJChunk;
+
+char* readWholeFile(const char* path, size_t* length);
+
+int parseOBJ(const char* text, size_t length, OBJData* out);
+int parseOBJParallel(const char* text, size_t length, OBJData* out, int threadCount);
+void freeOBJData(OBJData* data);
+
+Mesh* meshesFromOBJData(const OBJData* data, const char* fileName, int* meshCount);
+
+const char* parseDouble(const char* p, double* out);
+const char* parseInt(const char* p, int* out);
+const char* parseName(const char* p, char* out, size_t size);
+
+#endif //CUBERENDER_OBJPARSE_H
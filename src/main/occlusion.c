@@ -0,0 +1,220 @@
+// Coarse CPU depth buffer for whole object occlusion culling
+// Created by James Schaffer on 16/10/2026.
+
+#include "occlusion.h"
+
+#include <math.h>
+#include <string.h>
+
+void occlusionBegin(OcclusionBuffer* buffer, const float screenWidth, const float screenHeight) {
+	memset(buffer->invW, 0, sizeof(buffer->invW));
+
+	buffer->scaleX = OCCLUSION_WIDTH / screenWidth;
+	buffer->scaleY = OCCLUSION_HEIGHT / screenHeight;
+	buffer->written = false;
+}
+
+// ========== OCCLUDERS ==========
+
+// Sub pixel bits of the fixed point edge functions. Shared edges evaluate to exactly opposite values in
+// both triangles, so with the top-left rule every pixel centre along them belongs to exactly one
+#define OCCLUSION_SUBPIXEL_BITS	8
+#define OCCLUSION_SUBPIXEL		(1 << OCCLUSION_SUBPIXEL_BITS)
+
+void occlusionBeginMesh(OcclusionBuffer* buffer) {
+	// Empty rectangle, grown by each triangle
+	buffer->meshX0 = OCCLUSION_WIDTH;
+	buffer->meshY0 = OCCLUSION_HEIGHT;
+	buffer->meshX1 = -1;
+	buffer->meshY1 = -1;
+}
+
+// Grows the mesh rectangle to take in [x0, x1] x [y0, y1], clearing only the pixels it gains
+static void growMeshRect(OcclusionBuffer* buffer, const int x0, const int y0, const int x1, const int y1) {
+	const int oldX0 = buffer->meshX0, oldY0 = buffer->meshY0;
+	const int oldX1 = buffer->meshX1, oldY1 = buffer->meshY1;
+
+	const int newX0 = SDL_min(oldX0, x0), newY0 = SDL_min(oldY0, y0);
+	const int newX1 = SDL_max(oldX1, x1), newY1 = SDL_max(oldY1, y1);
+
+	if (newX0 == oldX0 && newY0 == oldY0 && newX1 == oldX1 && newY1 == oldY1) return;
+
+	for (int iy=newY0; iy<=newY1; ++iy) {
+		float* row = buffer->meshInvW + (iy + 1) * OCCLUSION_MESH_STRIDE + 1;
+
+		// Whole new rows, or the parts of old rows left and right of the old rectangle
+		if (iy < oldY0 || iy > oldY1 || oldX0 > oldX1) {
+			for (int ix=newX0; ix<=newX1; ++ix) row[ix] = INFINITY;
+		} else {
+			for (int ix=newX0; ix<oldX0; ++ix) row[ix] = INFINITY;
+			for (int ix=oldX1 + 1; ix<=newX1; ++ix) row[ix] = INFINITY;
+		}
+	}
+
+	buffer->meshX0 = newX0;
+	buffer->meshY0 = newY0;
+	buffer->meshX1 = newX1;
+	buffer->meshY1 = newY1;
+}
+
+void occlusionDrawTri(OcclusionBuffer* buffer, const float x[3], const float y[3], const float invW[3]) {
+	float px[3], py[3];
+	Sint64 fx[3], fy[3];
+
+	for (int i=0; i<3; ++i) {
+		px[i] = x[i] * buffer->scaleX;
+		py[i] = y[i] * buffer->scaleY;
+
+		// Way off screen corners would overflow the fixed point maths, those triangles are just skipped
+		if (!(fabsf(px[i]) < 65536.0f && fabsf(py[i]) < 65536.0f)) return;
+
+		fx[i] = (Sint64)lrintf(px[i] * OCCLUSION_SUBPIXEL);
+		fy[i] = (Sint64)lrintf(py[i] * OCCLUSION_SUBPIXEL);
+	}
+
+	const Sint64 area = (fx[1] - fx[0]) * (fy[2] - fy[0]) - (fy[1] - fy[0]) * (fx[2] - fx[0]);
+	if (area == 0) return;
+
+	// Edge i runs from corner i to i+1 as a*x + b*y + c, flipped so inside is positive for either winding.
+	// Pixel centres exactly on an edge are only inside for top and left edges
+	Sint64 a[3], b[3], c[3];
+
+	for (int i=0; i<3; ++i) {
+		const int j = (i + 1) % 3;
+
+		a[i] = fy[i] - fy[j];
+		b[i] = fx[j] - fx[i];
+		if (area < 0) {
+			a[i] = -a[i];
+			b[i] = -b[i];
+		}
+		c[i] = -(a[i] * fx[i] + b[i] * fy[i]);
+
+		const bool topLeft = a[i] > 0 || (a[i] == 0 && b[i] > 0);
+		if (!topLeft) c[i] -= 1;
+	}
+
+	// 1/w as a plane over the screen
+	const float fArea = (px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]);
+	if (fArea == 0.0f) return;
+
+	const float depthA = ((invW[1] - invW[0]) * (py[2] - py[0]) - (invW[2] - invW[0]) * (py[1] - py[0])) / fArea;
+	const float depthB = ((invW[2] - invW[0]) * (px[1] - px[0]) - (invW[1] - invW[0]) * (px[2] - px[0])) / fArea;
+	const float depthC = invW[0] - depthA * px[0] - depthB * py[0];
+
+	// The plane over a whole pixel can reach past the triangle, it's never farther than the farthest corner
+	const float depthBias = SDL_min(depthA, 0.0f) + SDL_min(depthB, 0.0f);
+	const float depthFloor = SDL_max(SDL_min(invW[0], SDL_min(invW[1], invW[2])), 0.0f);
+
+	// Pixels whose centre (ix + 0.5, iy + 0.5) can be inside, including the ring just off screen
+	const int x0 = SDL_max((int)ceilf(SDL_min(px[0], SDL_min(px[1], px[2])) - 0.5f), -1);
+	const int y0 = SDL_max((int)ceilf(SDL_min(py[0], SDL_min(py[1], py[2])) - 0.5f), -1);
+	const int x1 = SDL_min((int)floorf(SDL_max(px[0], SDL_max(px[1], px[2])) - 0.5f), OCCLUSION_WIDTH);
+	const int y1 = SDL_min((int)floorf(SDL_max(py[0], SDL_max(py[1], py[2])) - 0.5f), OCCLUSION_HEIGHT);
+
+	if (x0 > x1 || y0 > y1) return;
+
+	growMeshRect(buffer, x0, y0, x1, y1);
+
+	for (int iy=y0; iy<=y1; ++iy) {
+		float* row = buffer->meshInvW + (iy + 1) * OCCLUSION_MESH_STRIDE + 1;
+		const Sint64 cy = (Sint64)iy * OCCLUSION_SUBPIXEL + OCCLUSION_SUBPIXEL / 2;
+
+		for (int ix=x0; ix<=x1; ++ix) {
+			const Sint64 cx = (Sint64)ix * OCCLUSION_SUBPIXEL + OCCLUSION_SUBPIXEL / 2;
+
+			if (a[0] * cx + b[0] * cy + c[0] < 0) continue;
+			if (a[1] * cx + b[1] * cy + c[1] < 0) continue;
+			if (a[2] * cx + b[2] * cy + c[2] < 0) continue;
+
+			// Farthest the triangle gets over the pixel, the mesh keeps the farthest of its triangles
+			const float farthest = SDL_max(depthA * ix + depthB * iy + depthC + depthBias, depthFloor);
+			if (farthest < row[ix]) row[ix] = farthest;
+		}
+	}
+}
+
+// Pixel centres only say the mesh is there somewhere in the pixel. A pixel whose 3x3 neighbourhood is all
+// covered is covered completely, and gets the farthest depth of the neighbourhood
+void occlusionEndMesh(OcclusionBuffer* buffer) {
+	// Pixels on the rectangle's border have a neighbour that was never cleared, and can't be covered anyway
+	const int x0 = SDL_max(buffer->meshX0 + 1, 0);
+	const int y0 = SDL_max(buffer->meshY0 + 1, 0);
+	const int x1 = SDL_min(buffer->meshX1 - 1, OCCLUSION_WIDTH - 1);
+	const int y1 = SDL_min(buffer->meshY1 - 1, OCCLUSION_HEIGHT - 1);
+
+	for (int iy=y0; iy<=y1; ++iy) {
+		float* row = buffer->invW + iy * OCCLUSION_WIDTH;
+
+		for (int ix=x0; ix<=x1; ++ix) {
+			float farthest = INFINITY;
+			bool covered = true;
+
+			for (int dy=-1; dy<=1 && covered; ++dy) {
+				const float* meshRow = buffer->meshInvW + (iy + dy + 1) * OCCLUSION_MESH_STRIDE + 1;
+
+				for (int dx=-1; dx<=1; ++dx) {
+					const float depth = meshRow[ix + dx];
+
+					covered = covered && depth != INFINITY;
+					farthest = SDL_min(farthest, depth);
+				}
+			}
+
+			if (covered && farthest > row[ix]) {
+				row[ix] = farthest;
+				buffer->written = true;
+			}
+		}
+	}
+}
+
+// ========== OCCLUDEES ==========
+
+bool occlusionTestAABB(const OcclusionBuffer* buffer, const mat4* viewProjection, const AABB* box) {
+	if (!buffer->written) return false;
+
+	float minX = INFINITY, minY = INFINITY;
+	float maxX = -INFINITY, maxY = -INFINITY;
+	float nearest = 0.0f;
+
+	for (int i=0; i<8; ++i) {
+		const v3 corner = {
+			(i & 1) ? box->max.x : box->min.x,
+			(i & 2) ? box->max.y : box->min.y,
+			(i & 4) ? box->max.z : box->min.z
+		};
+		const v4 c = mat4MulPoint(viewProjection, corner);
+
+		// Reaches past the camera plane so it covers the view, nothing in front of it can hide it
+		if (c.z < 0 || c.w <= 0) return false;
+
+		const float invW = (float)(1.0 / c.w);
+		const float sx = (float)(1.0 + c.x * invW) * (OCCLUSION_WIDTH / 2.0f);
+		const float sy = (float)(1.0 + c.y * invW) * (OCCLUSION_HEIGHT / 2.0f);
+
+		minX = SDL_min(minX, sx);
+		minY = SDL_min(minY, sy);
+		maxX = SDL_max(maxX, sx);
+		maxY = SDL_max(maxY, sy);
+		nearest = SDL_max(nearest, invW);
+	}
+
+	const int x0 = SDL_max((int)floorf(minX), 0);
+	const int y0 = SDL_max((int)floorf(minY), 0);
+	const int x1 = SDL_min((int)floorf(maxX), OCCLUSION_WIDTH - 1);
+	const int y1 = SDL_min((int)floorf(maxY), OCCLUSION_HEIGHT - 1);
+
+	// Off screen, that's for the frustum tests to decide
+	if (x0 > x1 || y0 > y1) return false;
+
+	for (int iy=y0; iy<=y1; ++iy) {
+		const float* row = buffer->invW + iy * OCCLUSION_WIDTH;
+
+		for (int ix=x0; ix<=x1; ++ix) {
+			if (row[ix] <= nearest) return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,51 @@
+// Coarse CPU depth buffer for whole object occlusion culling
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_OCCLUSION_H
+#define CUBERENDER_OCCLUSION_H
+
+#include <SDL3/SDL_stdinc.h>
+
+#include "vector.h"
+
+// 1/7.5 of a 1920x1080 window, each occlusion pixel covers a 7.5x7.5 block of the screen
+#define OCCLUSION_WIDTH		256
+#define OCCLUSION_HEIGHT	144
+
+#define OCCLUSION_MESH_STRIDE	(OCCLUSION_WIDTH + 2)
+
+// Both sides are conservative so an object is never culled when any of it could be seen :
+// an occluder is rasterized as a whole mesh (pixel centres, top-left rule so shared edges leave no cracks)
+// keeping the farthest depth each covering triangle has over the pixel, then the coverage is eroded by one
+// pixel so only pixels the mesh covers completely reach the buffer. An object is only hidden if every pixel
+// under its screen rectangle is nearer than its nearest corner.
+// Depth is stored as 1/w (linear in screen space, bigger is nearer, 0 is empty)
+typedef struct {
+	float invW[OCCLUSION_WIDTH * OCCLUSION_HEIGHT];
+
+	// The occluder being drawn, INFINITY where no triangle covers the pixel centre. One pixel wider on every
+	// side so the erosion knows whether the mesh carries on past the screen edge. Only the rectangle the
+	// mesh touched [meshX0, meshX1] x [meshY0, meshY1] (screen pixels, -1 to size) is cleared and merged
+	float meshInvW[OCCLUSION_MESH_STRIDE * (OCCLUSION_HEIGHT + 2)];
+	int meshX0, meshY0, meshX1, meshY1;
+
+	// Screen pixels -> occlusion pixels
+	float scaleX, scaleY;
+
+	// Set once an occluder has written anything this frame, tests are skipped until then
+	bool written;
+} OcclusionBuffer;
+
+void occlusionBegin(OcclusionBuffer* buffer, float screenWidth, float screenHeight);
+
+// Every triangle of one occluder goes between occlusionBeginMesh and occlusionEndMesh
+void occlusionBeginMesh(OcclusionBuffer* buffer);
+void occlusionEndMesh(OcclusionBuffer* buffer);
+
+// x, y in screen pixels, invW per corner. Either winding
+void occlusionDrawTri(OcclusionBuffer* buffer, const float x[3], const float y[3], const float invW[3]);
+
+// True if the world space box is completely hidden behind what has been drawn
+bool occlusionTestAABB(const OcclusionBuffer* buffer, const mat4* viewProjection, const AABB* box);
+
+#endif //CUBERENDER_OCCLUSION_H
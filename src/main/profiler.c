@@ -0,0 +1,127 @@
+// Per-stage frame timers and counters with rolling percentiles
+// Created by James Schaffer on 16/10/2026.
+
+#include "profiler.h"
+
+#if PROFILE_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Profiler profiler = {0};
+
+static const char* STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+	"update", "scene", "cull", "occlusion", "project", "faces", "sort", "submit", "geometry", "raster", "present", "frame"
+};
+
+static const char* COUNTER_NAMES[PROFILE_COUNTER_COUNT] = {
+	"faces tested", "faces culled", "tris submitted", "draw calls", "state changes", "objects occluded"
+};
+
+const char* getProfileStageName(const ProfileStage stage) {
+	return STAGE_NAMES[stage];
+}
+
+const char* getProfileCounterName(const ProfileCounter counter) {
+	return COUNTER_NAMES[counter];
+}
+
+// Moves the frame's totals into the ring buffers and starts the next frame from zero
+void profileEndFrame() {
+	for (int s=0; s<PROFILE_STAGE_COUNT; ++s) {
+		profiler.tickHistory[s][profiler.head] = profiler.frameTicks[s];
+	}
+	for (int c=0; c<PROFILE_COUNTER_COUNT; ++c) {
+		profiler.countHistory[c][profiler.head] = profiler.frameCounts[c];
+	}
+
+	memset(profiler.frameTicks, 0, sizeof(profiler.frameTicks));
+	memset(profiler.frameCounts, 0, sizeof(profiler.frameCounts));
+
+	profiler.head = (profiler.head + 1) % PROFILE_HISTORY;
+	if (profiler.filled < PROFILE_HISTORY) profiler.filled++;
+}
+
+static int compareTicks(const void* a, const void* b) {
+	const Uint64 x = *(const Uint64*)a, y = *(const Uint64*)b;
+	return (x > y) - (x < y);
+}
+
+// Sorts a copy of each ring buffer, only called when printing / drawing so a few hundred entries is cheap
+ProfileStats profileGetStats() {
+	ProfileStats stats = {0};
+	stats.frames = profiler.filled;
+	if (profiler.filled == 0) return stats;
+
+	const double msPerTick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+	Uint64 sorted[PROFILE_HISTORY];
+
+	for (int s=0; s<PROFILE_STAGE_COUNT; ++s) {
+		memcpy(sorted, profiler.tickHistory[s], profiler.filled * sizeof(Uint64));
+		qsort(sorted, profiler.filled, sizeof(Uint64), compareTicks);
+
+		// Nearest rank
+		const int p50 = (profiler.filled * 50 + 99) / 100;
+		const int p99 = (profiler.filled * 99 + 99) / 100;
+
+		stats.p50Ms[s] = sorted[p50 - 1] * msPerTick;
+		stats.p99Ms[s] = sorted[p99 - 1] * msPerTick;
+	}
+
+	for (int c=0; c<PROFILE_COUNTER_COUNT; ++c) {
+		Uint64 total = 0;
+		for (int i=0; i<profiler.filled; ++i) total += profiler.countHistory[c][i];
+
+		stats.countMean[c] = (double)total / profiler.filled;
+	}
+
+	return stats;
+}
+
+void profilePrint() {
+	const ProfileStats stats = profileGetStats();
+	if (stats.frames == 0) return;
+
+	// p50/p99 in ms for each stage, then per frame averages of the counters
+	printf("  ms p50/p99 :");
+	for (int s=0; s<PROFILE_STAGE_COUNT; ++s) {
+		printf(" %s %.2f/%.2f", STAGE_NAMES[s], stats.p50Ms[s], stats.p99Ms[s]);
+	}
+	printf("\n  per frame :");
+	for (int c=0; c<PROFILE_COUNTER_COUNT; ++c) {
+		printf(" %s %.0f%s", COUNTER_NAMES[c], stats.countMean[c], c + 1 < PROFILE_COUNTER_COUNT ? "," : "");
+	}
+	printf("\n");
+}
+
+// SDL's built in 8x8 debug font, one line per stage / counter in the top left
+void profileDrawOverlay(SDL_Renderer* renderer) {
+	if (!profiler.overlay) return;
+
+	const ProfileStats stats = profileGetStats();
+	const float lineHeight = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE + 2;
+	float y = 8;
+	char line[96];
+
+	SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+
+	snprintf(line, sizeof(line), "stage       p50ms   p99ms  (%i frames)", stats.frames);
+	SDL_RenderDebugText(renderer, 8, y, line);
+	y += lineHeight;
+
+	for (int s=0; s<PROFILE_STAGE_COUNT; ++s) {
+		snprintf(line, sizeof(line), "%-10s %6.2f  %6.2f", STAGE_NAMES[s], stats.p50Ms[s], stats.p99Ms[s]);
+		SDL_RenderDebugText(renderer, 8, y, line);
+		y += lineHeight;
+	}
+
+	y += lineHeight;
+	for (int c=0; c<PROFILE_COUNTER_COUNT; ++c) {
+		snprintf(line, sizeof(line), "%-15s %9.0f", COUNTER_NAMES[c], stats.countMean[c]);
+		SDL_RenderDebugText(renderer, 8, y, line);
+		y += lineHeight;
+	}
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Per-stage frame timers and counters with rolling percentiles
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_PROFILER_H
+#define CUBERENDER_PROFILER_H
+
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_timer.h>
+
+// Build with -DPROFILE_ENABLED=0 and every PROFILE_* macro below expands to nothing
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+
+// Frames kept per stage for the rolling percentiles
+#define PROFILE_HISTORY 256
+
+typedef enum {
+	PROFILE_STAGE_UPDATE,	// update() and pushing transforms into the scene
+	PROFILE_STAGE_SCENE,	// BVH refit / query and object ordering
+	PROFILE_STAGE_CULL,		// whole mesh sphere / box tests
+	PROFILE_STAGE_OCCLUSION,	// drawing occluders into the coarse depth buffer and testing bounds against it
+	PROFILE_STAGE_PROJECT,	// per-vertex transform
+	PROFILE_STAGE_FACES,	// per-face rejection and shading (and submission when painter's sort is off)
+	PROFILE_STAGE_SORT,		// face depth sort
+	PROFILE_STAGE_SUBMIT,	// building sorted triangles into the batch / rasterizer
+	PROFILE_STAGE_GEOMETRY,	// SDL_RenderGeometry calls
+	PROFILE_STAGE_RASTER,	// tiled rasterizer flush
+	PROFILE_STAGE_PRESENT,	// SDL_RenderPresent
+	PROFILE_STAGE_FRAME,	// whole loop iteration
+
+	PROFILE_STAGE_COUNT
+} ProfileStage;
+
+typedef enum {
+	PROFILE_COUNTER_FACES_TESTED,
+	PROFILE_COUNTER_FACES_CULLED,
+	PROFILE_COUNTER_TRIS_SUBMITTED,
+	PROFILE_COUNTER_DRAW_CALLS,
+	PROFILE_COUNTER_STATE_CHANGES,	// texture / blend mode switches between consecutive triangles
+	PROFILE_COUNTER_OCCLUDED,		// objects hidden by the occlusion buffer
+
+	PROFILE_COUNTER_COUNT
+} ProfileCounter;
+
+typedef struct {
+	// Running totals for the frame in progress (stages can be entered many times, once per mesh)
+	Uint64 frameTicks[PROFILE_STAGE_COUNT];
+	Uint64 frameCounts[PROFILE_COUNTER_COUNT];
+
+	// Ring buffers of finished frames
+	Uint64 tickHistory[PROFILE_STAGE_COUNT][PROFILE_HISTORY];
+	Uint64 countHistory[PROFILE_COUNTER_COUNT][PROFILE_HISTORY];
+	int head, filled;
+
+	bool overlay;
+} Profiler;
+
+typedef struct {
+	double p50Ms[PROFILE_STAGE_COUNT];
+	double p99Ms[PROFILE_STAGE_COUNT];
+	double countMean[PROFILE_COUNTER_COUNT];
+	int frames;
+} ProfileStats;
+
+#if PROFILE_ENABLED
+
+extern Profiler profiler;
+
+// Begin / end have to be in the same scope, the start time is a local named after the stage
+#define PROFILE_BEGIN(stage)	const Uint64 profileStart_##stage = SDL_GetPerformanceCounter()
+#define PROFILE_END(stage)		(profiler.frameTicks[stage] += SDL_GetPerformanceCounter() - profileStart_##stage)
+#define PROFILE_COUNT(counter, n)	(profiler.frameCounts[counter] += (Uint64)(n))
+
+#define PROFILE_END_FRAME()				profileEndFrame()
+#define PROFILE_PRINT()					profilePrint()
+#define PROFILE_DRAW_OVERLAY(renderer)	profileDrawOverlay(renderer)
+#define PROFILE_TOGGLE_OVERLAY()		(profiler.overlay = !profiler.overlay)
+
+void profileEndFrame();
+ProfileStats profileGetStats();
+void profilePrint();
+void profileDrawOverlay(SDL_Renderer* renderer);
+
+const char* getProfileStageName(ProfileStage stage);
+const char* getProfileCounterName(ProfileCounter counter);
+
+#else
+
+#define PROFILE_BEGIN(stage)			((void)0)
+#define PROFILE_END(stage)				((void)0)
+#define PROFILE_COUNT(counter, n)		((void)0)
+
+#define PROFILE_END_FRAME()				((void)0)
+#define PROFILE_PRINT()					((void)0)
+#define PROFILE_DRAW_OVERLAY(renderer)	((void)0)
+#define PROFILE_TOGGLE_OVERLAY()		((void)0)
+
+#endif
+
+#endif //CUBERENDER_PROFILER_H
@@ -0,0 +1,259 @@
+// Per-frame vertex transform + projection kernels
+// Created by James Schaffer on 16/10/2026.
+
+#include "project.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <SDL3/SDL_cpuinfo.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define PROJECT_X86 1
+	#include <immintrin.h>
+#endif
+
+// GCC / Clang need AVX enabled per function, MSVC allows the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+	#define PROJECT_TARGET_AVX __attribute__((target("avx")))
+#else
+	#define PROJECT_TARGET_AVX
+#endif
+
+// ========== OUTPUT BUFFERS ==========
+
+// Buffers for count vertices from the arena, valid until it's reset
+void allocProjectedVertices(ProjectedVertices* projected, Arena* arena, const size_t count) {
+	// Padded to whole 8 wide vectors like the MeshSoA streams
+	const size_t padded = (count + 7) & ~(size_t)7;
+
+	projected->x = ARENA_ARRAY(arena, float, padded);
+	projected->y = ARENA_ARRAY(arena, float, padded);
+	projected->depth = ARENA_ARRAY(arena, float, padded);
+	projected->outcode = ARENA_ARRAY(arena, Uint8, padded);
+	projected->capacity = padded;
+}
+
+// ========== KERNELS ==========
+// All kernels do the same maths as projectMeshVertices (main.c) in float :
+// clip = mvp * (x,y,z,1), outcode = clipOutcode(clip),
+// screen = (1 + clip.xy / clip.w) * half screen size (clipToScreen), depth = clip.w
+
+static void projectScalar(const MeshSoA* soa, const float* m, float halfW, float halfH, size_t begin, ProjectedVertices* out) {
+	for (size_t i=begin; i<soa->count; ++i) {
+		const float x = soa->x[i];
+		const float y = soa->y[i];
+		const float z = soa->z[i];
+
+		const float cx = m[0]*x + m[1]*y + m[2]*z + m[3];
+		const float cy = m[4]*x + m[5]*y + m[6]*z + m[7];
+		const float cz = m[8]*x + m[9]*y + m[10]*z + m[11];
+		const float cw = m[12]*x + m[13]*y + m[14]*z + m[15];
+
+		const float invW = 1.0f / cw;
+
+		out->x[i] = (1.0f + cx * invW) * halfW;
+		out->y[i] = (1.0f + cy * invW) * halfH;
+		out->depth[i] = cw;
+
+		Uint8 code = 0;
+		if (cx < -cw) code |= CLIP_LEFT;
+		if (cx > cw) code |= CLIP_RIGHT;
+		if (cy < -cw) code |= CLIP_BOTTOM;
+		if (cy > cw) code |= CLIP_TOP;
+		if (cz < 0.0f) code |= CLIP_NEAR;
+		if (cz > cw) code |= CLIP_FAR;
+		out->outcode[i] = code;
+	}
+}
+
+#ifdef PROJECT_X86
+
+static void projectSSE2(const MeshSoA* soa, const float* m, float halfW, float halfH, ProjectedVertices* out) {
+	__m128 r[16];
+	for (int k=0; k<16; ++k) r[k] = _mm_set1_ps(m[k]);
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	__m128 bit[6];
+	for (int k=0; k<6; ++k) bit[k] = _mm_castsi128_ps(_mm_set1_epi32(1 << k));
+	const __m128 hw = _mm_set1_ps(halfW);
+	const __m128 hh = _mm_set1_ps(halfH);
+
+	size_t i = 0;
+	for (; i + 4 <= soa->count; i += 4) {
+		const __m128 x = _mm_load_ps(soa->x + i);
+		const __m128 y = _mm_load_ps(soa->y + i);
+		const __m128 z = _mm_load_ps(soa->z + i);
+
+		const __m128 cx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], x), _mm_mul_ps(r[1], y)), _mm_add_ps(_mm_mul_ps(r[2], z), r[3]));
+		const __m128 cy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[4], x), _mm_mul_ps(r[5], y)), _mm_add_ps(_mm_mul_ps(r[6], z), r[7]));
+		const __m128 cz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[8], x), _mm_mul_ps(r[9], y)), _mm_add_ps(_mm_mul_ps(r[10], z), r[11]));
+		const __m128 cw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[12], x), _mm_mul_ps(r[13], y)), _mm_add_ps(_mm_mul_ps(r[14], z), r[15]));
+
+		const __m128 invW = _mm_div_ps(one, cw);
+
+		_mm_store_ps(out->x + i, _mm_mul_ps(_mm_add_ps(one, _mm_mul_ps(cx, invW)), hw));
+		_mm_store_ps(out->y + i, _mm_mul_ps(_mm_add_ps(one, _mm_mul_ps(cy, invW)), hh));
+		_mm_store_ps(out->depth + i, cw);
+
+		// Same bit order as the CLIP_* defines
+		const __m128 negW = _mm_sub_ps(zero, cw);
+		__m128 code = _mm_and_ps(_mm_cmplt_ps(cx, negW), bit[0]);
+		code = _mm_or_ps(code, _mm_and_ps(_mm_cmpgt_ps(cx, cw), bit[1]));
+		code = _mm_or_ps(code, _mm_and_ps(_mm_cmplt_ps(cy, negW), bit[2]));
+		code = _mm_or_ps(code, _mm_and_ps(_mm_cmpgt_ps(cy, cw), bit[3]));
+		code = _mm_or_ps(code, _mm_and_ps(_mm_cmplt_ps(cz, zero), bit[4]));
+		code = _mm_or_ps(code, _mm_and_ps(_mm_cmpgt_ps(cz, cw), bit[5]));
+
+		// 4 x int32 -> 4 bytes
+		__m128i packed = _mm_castps_si128(code);
+		packed = _mm_packs_epi32(packed, packed);
+		packed = _mm_packus_epi16(packed, packed);
+
+		const int codes = _mm_cvtsi128_si32(packed);
+		memcpy(out->outcode + i, &codes, 4);
+	}
+
+	projectScalar(soa, m, halfW, halfH, i, out);
+}
+
+PROJECT_TARGET_AVX
+static void projectAVX(const MeshSoA* soa, const float* m, float halfW, float halfH, ProjectedVertices* out) {
+	__m256 r[16];
+	for (int k=0; k<16; ++k) r[k] = _mm256_set1_ps(m[k]);
+
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	__m256 bit[6];
+	for (int k=0; k<6; ++k) bit[k] = _mm256_castsi256_ps(_mm256_set1_epi32(1 << k));
+	const __m256 hw = _mm256_set1_ps(halfW);
+	const __m256 hh = _mm256_set1_ps(halfH);
+
+	size_t i = 0;
+	for (; i + 8 <= soa->count; i += 8) {
+		const __m256 x = _mm256_load_ps(soa->x + i);
+		const __m256 y = _mm256_load_ps(soa->y + i);
+		const __m256 z = _mm256_load_ps(soa->z + i);
+
+		const __m256 cx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[0], x), _mm256_mul_ps(r[1], y)), _mm256_add_ps(_mm256_mul_ps(r[2], z), r[3]));
+		const __m256 cy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[4], x), _mm256_mul_ps(r[5], y)), _mm256_add_ps(_mm256_mul_ps(r[6], z), r[7]));
+		const __m256 cz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[8], x), _mm256_mul_ps(r[9], y)), _mm256_add_ps(_mm256_mul_ps(r[10], z), r[11]));
+		const __m256 cw = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[12], x), _mm256_mul_ps(r[13], y)), _mm256_add_ps(_mm256_mul_ps(r[14], z), r[15]));
+
+		const __m256 invW = _mm256_div_ps(one, cw);
+
+		_mm256_store_ps(out->x + i, _mm256_mul_ps(_mm256_add_ps(one, _mm256_mul_ps(cx, invW)), hw));
+		_mm256_store_ps(out->y + i, _mm256_mul_ps(_mm256_add_ps(one, _mm256_mul_ps(cy, invW)), hh));
+		_mm256_store_ps(out->depth + i, cw);
+
+		// Same bit order as the CLIP_* defines
+		const __m256 negW = _mm256_sub_ps(zero, cw);
+		__m256 code = _mm256_and_ps(_mm256_cmp_ps(cx, negW, _CMP_LT_OQ), bit[0]);
+		code = _mm256_or_ps(code, _mm256_and_ps(_mm256_cmp_ps(cx, cw, _CMP_GT_OQ), bit[1]));
+		code = _mm256_or_ps(code, _mm256_and_ps(_mm256_cmp_ps(cy, negW, _CMP_LT_OQ), bit[2]));
+		code = _mm256_or_ps(code, _mm256_and_ps(_mm256_cmp_ps(cy, cw, _CMP_GT_OQ), bit[3]));
+		code = _mm256_or_ps(code, _mm256_and_ps(_mm256_cmp_ps(cz, zero, _CMP_LT_OQ), bit[4]));
+		code = _mm256_or_ps(code, _mm256_and_ps(_mm256_cmp_ps(cz, cw, _CMP_GT_OQ), bit[5]));
+
+		// 8 x int32 -> 8 bytes, AVX1 has no 256 bit integer packs so go through the two halves
+		const __m256i codeInt = _mm256_castps_si256(code);
+		__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(codeInt), _mm256_extractf128_si256(codeInt, 1));
+		packed = _mm_packus_epi16(packed, packed);
+
+		_mm_storel_epi64((__m128i*)(out->outcode + i), packed);
+	}
+
+	projectScalar(soa, m, halfW, halfH, i, out);
+}
+
+#endif
+
+// ========== KERNEL SELECTION ==========
+
+static int selectedKernel = -1;
+
+// Picks the widest kernel the CPU supports, checked once at first use
+ProjectKernel getProjectKernel() {
+	if (selectedKernel != -1) return selectedKernel;
+
+	selectedKernel = PROJECT_KERNEL_SCALAR;
+
+#ifdef PROJECT_X86
+	if (SDL_HasAVX()) {
+		selectedKernel = PROJECT_KERNEL_AVX;
+	} else if (SDL_HasSSE2()) {
+		selectedKernel = PROJECT_KERNEL_SSE2;
+	}
+#endif
+
+	printf("Projection kernel : %s\n", getProjectKernelName(selectedKernel));
+
+	return selectedKernel;
+}
+
+const char* getProjectKernelName(ProjectKernel kernel) {
+	switch (kernel) {
+		case PROJECT_KERNEL_SSE2:
+			return "SSE2";
+		case PROJECT_KERNEL_AVX:
+			return "AVX";
+		default:
+			return "scalar";
+	}
+}
+
+// Transforms and projects every vertex of the SoA mirror into out
+void projectSoA(const MeshSoA* soa, const mat4* mvp, float screenWidth, float screenHeight, ProjectedVertices* out) {
+	float m[16];
+	for (int i=0; i<16; ++i) {
+		m[i] = (float)(&mvp->m[0][0])[i];
+	}
+
+	const float halfW = screenWidth / 2.0f;
+	const float halfH = screenHeight / 2.0f;
+
+	switch (getProjectKernel()) {
+#ifdef PROJECT_X86
+		case PROJECT_KERNEL_AVX:
+			projectAVX(soa, m, halfW, halfH, out);
+			break;
+		case PROJECT_KERNEL_SSE2:
+			projectSSE2(soa, m, halfW, halfH, out);
+			break;
+#endif
+		default:
+			projectScalar(soa, m, halfW, halfH, 0, out);
+			break;
+	}
+}
+
+// ========== LIGHTING ==========
+
+// Plain float loop over the normal streams, no dependencies between iterations so the compiler vectorises it
+void lightSoA(const MeshSoA* soa, const mat4* normalMatrix, const v3 lightDir, const float ambient, float* out) {
+	const double (*r)[4] = normalMatrix->m;
+
+	const float m00 = (float)r[0][0], m01 = (float)r[0][1], m02 = (float)r[0][2];
+	const float m10 = (float)r[1][0], m11 = (float)r[1][1], m12 = (float)r[1][2];
+	const float m20 = (float)r[2][0], m21 = (float)r[2][1], m22 = (float)r[2][2];
+
+	// Facing the light is facing against the direction it travels
+	const float lx = (float)-lightDir.x, ly = (float)-lightDir.y, lz = (float)-lightDir.z;
+	const float diffuse = 1.0f - ambient;
+
+	for (size_t i=0; i<soa->normalCount; ++i) {
+		const float nx = soa->nx[i], ny = soa->ny[i], nz = soa->nz[i];
+
+		const float wx = m00 * nx + m01 * ny + m02 * nz;
+		const float wy = m10 * nx + m11 * ny + m12 * nz;
+		const float wz = m20 * nx + m21 * ny + m22 * nz;
+
+		const float lenSq = wx * wx + wy * wy + wz * wz;
+		float d = (wx * lx + wy * ly + wz * lz) / sqrtf(lenSq > 0.0f ? lenSq : 1.0f);
+		d = d > 0.0f ? d : 0.0f;
+
+		out[i] = ambient + diffuse * d;
+	}
+}
@@ -0,0 +1,42 @@
+// Per-frame vertex transform + projection kernels
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_PROJECT_H
+#define CUBERENDER_PROJECT_H
+
+#include <SDL3/SDL_stdinc.h>
+
+#include "arena.h"
+#include "clip.h"
+#include "mesh.h"
+#include "vector.h"
+
+// Screen space position of each mesh vertex, filled once per frame
+typedef struct {
+	float* x;
+	float* y;
+	float* depth; // view space depth (clip w)
+	Uint8* outcode; // CLIP_* bits, 0 when inside the frustum
+
+	size_t capacity;
+} ProjectedVertices;
+
+typedef enum {
+	PROJECT_KERNEL_SCALAR,
+	PROJECT_KERNEL_SSE2,
+	PROJECT_KERNEL_AVX
+} ProjectKernel;
+
+void allocProjectedVertices(ProjectedVertices* projected, Arena* arena, size_t count);
+
+ProjectKernel getProjectKernel();
+const char* getProjectKernelName(ProjectKernel kernel);
+
+// out needs room for soa->count vertices (allocProjectedVertices)
+void projectSoA(const MeshSoA* soa, const mat4* mvp, float screenWidth, float screenHeight, ProjectedVertices* out);
+
+// Sun + ambient brightness (0-1) of every normal in world space, lightDir is the normalised direction the light
+// travels. out needs room for soa->normalCount floats
+void lightSoA(const MeshSoA* soa, const mat4* normalMatrix, v3 lightDir, float ambient, float* out);
+
+#endif //CUBERENDER_PROJECT_H
@@ -0,0 +1,311 @@
+// Tiled multi-threaded software rasterizer
+// Created by James Schaffer on 16/10/2026.
+
+#include "raster.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+Rasterizer* createRasterizer(SDL_Renderer* renderer, int width, int height, int threadCount) {
+	Rasterizer* raster = calloc(1, sizeof(Rasterizer));
+	if (!raster) {
+		puts("Error allocating rasterizer");
+		raise(SIGTERM);
+	}
+
+	raster->width = width;
+	raster->height = height;
+	raster->tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	raster->tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	raster->clearColor = 0xFF000000;
+
+	raster->color = malloc((size_t)width * height * sizeof(Uint32));
+	raster->depth = malloc((size_t)width * height * sizeof(float));
+	raster->bins = calloc((size_t)raster->tilesX * raster->tilesY, sizeof(RasterBin));
+
+	if (!raster->color || !raster->depth || !raster->bins) {
+		puts("Error allocating rasterizer buffers");
+		raise(SIGTERM);
+	}
+
+	raster->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+	if (!raster->texture) {
+		SDL_Log("Failed to create raster texture: %s", SDL_GetError());
+	} else {
+		SDL_SetTextureBlendMode(raster->texture, SDL_BLENDMODE_NONE);
+	}
+
+	raster->pool = createThreadPool(threadCount);
+
+	return raster;
+}
+
+void destroyRasterizer(Rasterizer* raster) {
+	if (!raster) return;
+
+	destroyThreadPool(raster->pool);
+	if (raster->texture) SDL_DestroyTexture(raster->texture);
+
+	free(raster->bins);
+	free(raster->color);
+	free(raster->depth);
+	free(raster);
+}
+
+// Starts an empty frame, the triangle list and bins live in the arena until it's reset
+void rasterBegin(Rasterizer* raster, Arena* arena) {
+	if (raster->triCapacity < RASTER_INITIAL_TRIS) raster->triCapacity = RASTER_INITIAL_TRIS;
+
+	raster->arena = arena;
+	raster->tris = ARENA_ARRAY(arena, RasterTri, raster->triCapacity);
+	raster->triCount = 0;
+	raster->binTris = NULL;
+	raster->binTriCount = 0;
+
+	for (int i=0; i<raster->tilesX * raster->tilesY; ++i) {
+		raster->bins[i].count = 0;
+	}
+}
+
+// Stores the triangle and counts it in the bin of every tile its bounding box touches, the bins are filled on flush
+void rasterAddTri(Rasterizer* raster, const SDL_Vertex verts[3], const float invW[3], const TextureLevel* texture) {
+	float minX = verts[0].position.x, maxX = minX;
+	float minY = verts[0].position.y, maxY = minY;
+
+	for (int i=1; i<3; ++i) {
+		minX = fminf(minX, verts[i].position.x);
+		maxX = fmaxf(maxX, verts[i].position.x);
+		minY = fminf(minY, verts[i].position.y);
+		maxY = fmaxf(maxY, verts[i].position.y);
+	}
+
+	// Entirely off screen
+	if (maxX < 0 || maxY < 0 || minX >= raster->width || minY >= raster->height) return;
+
+	if (raster->triCount == raster->triCapacity) {
+		const size_t capacity = raster->triCapacity * 2;
+
+		raster->tris = arenaGrow(raster->arena, raster->tris, raster->triCapacity * sizeof(RasterTri), capacity * sizeof(RasterTri));
+		raster->triCapacity = capacity;
+	}
+
+	const Uint32 index = (Uint32)raster->triCount++;
+	RasterTri* tri = &raster->tris[index];
+
+	for (int i=0; i<3; ++i) {
+		tri->x[i] = verts[i].position.x;
+		tri->y[i] = verts[i].position.y;
+		tri->invW[i] = invW[i];
+		tri->color[i] = verts[i].color;
+		tri->u[i] = verts[i].tex_coord.x * invW[i];
+		tri->v[i] = verts[i].tex_coord.y * invW[i];
+	}
+
+	tri->texture = texture;
+
+	const int tx0 = SDL_max(0, (int)minX / RASTER_TILE_SIZE);
+	const int ty0 = SDL_max(0, (int)minY / RASTER_TILE_SIZE);
+	const int tx1 = SDL_min(raster->tilesX - 1, (int)maxX / RASTER_TILE_SIZE);
+	const int ty1 = SDL_min(raster->tilesY - 1, (int)maxY / RASTER_TILE_SIZE);
+
+	tri->tileX0 = (Uint16)tx0;
+	tri->tileY0 = (Uint16)ty0;
+	tri->tileX1 = (Uint16)tx1;
+	tri->tileY1 = (Uint16)ty1;
+
+	for (int ty=ty0; ty<=ty1; ++ty) {
+		for (int tx=tx0; tx<=tx1; ++tx) {
+			raster->bins[ty * raster->tilesX + tx].count++;
+		}
+	}
+
+	raster->binTriCount += (size_t)(tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+}
+
+// Counting sort of the triangles by tile : offsets from the counts, then one pass in submission order
+// fills every bin out of a single arena block
+static void fillBins(Rasterizer* raster) {
+	raster->binTris = ARENA_ARRAY(raster->arena, Uint32, raster->binTriCount);
+
+	Uint32 start = 0;
+	for (int i=0; i<raster->tilesX * raster->tilesY; ++i) {
+		raster->bins[i].start = start;
+		start += raster->bins[i].count;
+		raster->bins[i].count = 0;
+	}
+
+	for (size_t i=0; i<raster->triCount; ++i) {
+		const RasterTri* tri = &raster->tris[i];
+
+		for (int ty=tri->tileY0; ty<=tri->tileY1; ++ty) {
+			for (int tx=tri->tileX0; tx<=tri->tileX1; ++tx) {
+				RasterBin* bin = &raster->bins[ty * raster->tilesX + tx];
+				raster->binTris[bin->start + bin->count++] = (Uint32)i;
+			}
+		}
+	}
+}
+
+static Uint32 packColor(const float r, const float g, const float b) {
+	const Uint32 ri = (Uint32)(SDL_clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+	const Uint32 gi = (Uint32)(SDL_clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+	const Uint32 bi = (Uint32)(SDL_clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+	return 0xFF000000u | (ri << 16) | (gi << 8) | bi;
+}
+
+// Nearest texel, coordinates wrap (repeat) like the renderer's
+static Uint32 sampleTexture(const TextureLevel* level, const float u, const float v) {
+	int x = (int)floorf(u * (float)level->width) % level->width;
+	int y = (int)floorf(v * (float)level->height) % level->height;
+	if (x < 0) x += level->width;
+	if (y < 0) y += level->height;
+
+	return level->texels[TEXTURE_TEXEL_INDEX(level, x, y)];
+}
+
+// Half-space rasterization of one triangle, limited to the rect [x0,x1) x [y0,y1)
+static void rasterTri(Rasterizer* raster, const RasterTri* t, const int x0, const int y0, const int x1, const int y1) {
+	int a = 0, b = 1, c = 2;
+
+	float area = (t->x[b]-t->x[a])*(t->y[c]-t->y[a]) - (t->y[b]-t->y[a])*(t->x[c]-t->x[a]);
+	if (fabsf(area) < 1e-8f) return;
+
+	// Make the winding positive so inside is edge >= 0 for all three edges
+	if (area < 0) {
+		b = 2;
+		c = 1;
+		area = -area;
+	}
+
+	const float ax = t->x[a], ay = t->y[a];
+	const float bx = t->x[b], by = t->y[b];
+	const float cx = t->x[c], cy = t->y[c];
+
+	// Pixel bounds inside the tile, sampled at pixel centers
+	const int minX = SDL_max(x0, (int)floorf(fminf(ax, fminf(bx, cx))));
+	const int minY = SDL_max(y0, (int)floorf(fminf(ay, fminf(by, cy))));
+	const int maxX = SDL_min(x1 - 1, (int)ceilf(fmaxf(ax, fmaxf(bx, cx))));
+	const int maxY = SDL_min(y1 - 1, (int)ceilf(fmaxf(ay, fmaxf(by, cy))));
+
+	if (minX > maxX || minY > maxY) return;
+
+	// Edge functions e(p) = (q-p0) x (p-p0), stepped incrementally along x and y
+	const float e0dx = -(cy - by), e0dy = cx - bx;
+	const float e1dx = -(ay - cy), e1dy = ax - cx;
+	const float e2dx = -(by - ay), e2dy = bx - ax;
+
+	const float px = minX + 0.5f;
+	const float py = minY + 0.5f;
+
+	float e0row = (cx-bx)*(py-by) - (cy-by)*(px-bx);
+	float e1row = (ax-cx)*(py-cy) - (ay-cy)*(px-cx);
+	float e2row = (bx-ax)*(py-ay) - (by-ay)*(px-ax);
+
+	const float invArea = 1.0f / area;
+
+	const float wa = t->invW[a], wb = t->invW[b], wc = t->invW[c];
+	const SDL_FColor ca = t->color[a], cb = t->color[b], cc = t->color[c];
+
+	const TextureLevel* texture = t->texture;
+	const float ua = t->u[a], ub = t->u[b], uc = t->u[c];
+	const float va = t->v[a], vb = t->v[b], vc = t->v[c];
+
+	const bool flat = !texture && ca.r == cb.r && ca.r == cc.r && ca.g == cb.g && ca.g == cc.g && ca.b == cb.b && ca.b == cc.b;
+	const Uint32 flatColor = packColor(ca.r, ca.g, ca.b);
+
+	for (int y=minY; y<=maxY; ++y) {
+		float e0 = e0row, e1 = e1row, e2 = e2row;
+
+		Uint32* colorRow = raster->color + (size_t)y * raster->width;
+		float* depthRow = raster->depth + (size_t)y * raster->width;
+
+		for (int x=minX; x<=maxX; ++x) {
+			if (e0 >= 0 && e1 >= 0 && e2 >= 0) {
+				// Barycentric weights of a, b, c
+				const float la = e0 * invArea;
+				const float lb = e1 * invArea;
+				const float lc = e2 * invArea;
+
+				const float depth = la*wa + lb*wb + lc*wc;
+
+				// Larger 1/w is nearer
+				if (depth > depthRow[x]) {
+					depthRow[x] = depth;
+
+					if (flat) {
+						colorRow[x] = flatColor;
+					} else if (texture) {
+						// Perspective correct : u/w and v/w divided by the interpolated 1/w
+						const float invDepth = 1.0f / depth;
+						const Uint32 texel = sampleTexture(texture, (la*ua + lb*ub + lc*uc) * invDepth, (la*va + lb*vb + lc*vc) * invDepth);
+
+						colorRow[x] = packColor(
+							(la*ca.r + lb*cb.r + lc*cc.r) * (float)((texel >> 16) & 0xFF) * (1.0f / 255.0f),
+							(la*ca.g + lb*cb.g + lc*cc.g) * (float)((texel >> 8) & 0xFF) * (1.0f / 255.0f),
+							(la*ca.b + lb*cb.b + lc*cc.b) * (float)(texel & 0xFF) * (1.0f / 255.0f)
+						);
+					} else {
+						colorRow[x] = packColor(
+							la*ca.r + lb*cb.r + lc*cc.r,
+							la*ca.g + lb*cb.g + lc*cc.g,
+							la*ca.b + lb*cb.b + lc*cc.b
+						);
+					}
+				}
+			}
+
+			e0 += e0dx;
+			e1 += e1dx;
+			e2 += e2dx;
+		}
+
+		e0row += e0dy;
+		e1row += e1dy;
+		e2row += e2dy;
+	}
+}
+
+// One task per tile : clear its part of the framebuffer and z-buffer then draw its bin
+static void rasterTileTask(int task, int worker, void* userdata) {
+	Rasterizer* raster = userdata;
+	(void)worker;
+
+	const int tx = task % raster->tilesX;
+	const int ty = task / raster->tilesX;
+
+	const int x0 = tx * RASTER_TILE_SIZE;
+	const int y0 = ty * RASTER_TILE_SIZE;
+	const int x1 = SDL_min(x0 + RASTER_TILE_SIZE, raster->width);
+	const int y1 = SDL_min(y0 + RASTER_TILE_SIZE, raster->height);
+
+	for (int y=y0; y<y1; ++y) {
+		Uint32* colorRow = raster->color + (size_t)y * raster->width;
+		float* depthRow = raster->depth + (size_t)y * raster->width;
+
+		for (int x=x0; x<x1; ++x) {
+			colorRow[x] = raster->clearColor;
+			depthRow[x] = 0.0f;
+		}
+	}
+
+	const RasterBin* bin = &raster->bins[task];
+	const Uint32* binTris = raster->binTris + bin->start;
+
+	for (int i=0; i<bin->count; ++i) {
+		rasterTri(raster, &raster->tris[binTris[i]], x0, y0, x1, y1);
+	}
+}
+
+// Rasterizes every tile in parallel then draws the framebuffer to the renderer
+void rasterFlush(Rasterizer* raster, SDL_Renderer* renderer) {
+	fillBins(raster);
+	threadPoolRun(raster->pool, raster->tilesX * raster->tilesY, rasterTileTask, raster);
+
+	if (!raster->texture) return;
+
+	SDL_UpdateTexture(raster->texture, NULL, raster->color, raster->width * (int)sizeof(Uint32));
+	SDL_RenderTexture(renderer, raster->texture, NULL, NULL);
+}
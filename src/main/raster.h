@@ -0,0 +1,65 @@
+// Tiled multi-threaded software rasterizer
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_RASTER_H
+#define CUBERENDER_RASTER_H
+
+#include <SDL3/SDL_render.h>
+
+#include "arena.h"
+#include "texture.h"
+#include "threadpool.h"
+
+#define RASTER_TILE_SIZE		64
+// Triangle list size for the first frame, later frames start at the previous frame's size
+#define RASTER_INITIAL_TRIS		1024
+
+// Screen space triangle, invW (1/view depth) is linear in screen space so it's used as the depth value
+typedef struct {
+	float x[3], y[3];
+	float invW[3];
+	SDL_FColor color[3];
+
+	// Sampled level multiplied by the colour, NULL for untextured. u / v are pre-divided by w (u * invW)
+	// so they interpolate linearly in screen space like invW
+	const TextureLevel* texture;
+	float u[3], v[3];
+
+	Uint16 tileX0, tileY0, tileX1, tileY1; // tiles touched by the bounding box, inclusive
+} RasterTri;
+
+// Triangles touching a tile are binTris[start, start + count), in submission order
+typedef struct {
+	Uint32 start;
+	int count;
+} RasterBin;
+
+typedef struct {
+	int width, height;
+	int tilesX, tilesY;
+
+	Uint32* color; // ARGB8888
+	float* depth;
+	Uint32 clearColor;
+
+	// Per frame, from the arena given to rasterBegin
+	Arena* arena;
+	RasterTri* tris;
+	size_t triCount, triCapacity;
+	Uint32* binTris;
+	size_t binTriCount;
+
+	RasterBin* bins;
+
+	SDL_Texture* texture;
+	ThreadPool* pool;
+} Rasterizer;
+
+Rasterizer* createRasterizer(SDL_Renderer* renderer, int width, int height, int threadCount);
+void destroyRasterizer(Rasterizer* raster);
+
+void rasterBegin(Rasterizer* raster, Arena* arena);
+void rasterAddTri(Rasterizer* raster, const SDL_Vertex verts[3], const float invW[3], const TextureLevel* texture);
+void rasterFlush(Rasterizer* raster, SDL_Renderer* renderer);
+
+#endif //CUBERENDER_RASTER_H
@@ -0,0 +1,367 @@
+// Scene of mesh instances with a bounding volume hierarchy for culling
+// Created by James Schaffer on 16/10/2026.
+
+#include "scene.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+Scene newScene() {
+	return (Scene){0};
+}
+
+void freeScene(Scene* scene) {
+	if (!scene) return;
+
+	// Every object except instances owns its mesh data, the arrays below only hold the Mesh structs
+	for (int i=0; i<scene->objectCount; ++i) {
+		if (scene->objects[i].ownsMesh) {
+			freeMeshData(scene->objects[i].mesh);
+		}
+	}
+
+	for (int i=0; i<scene->meshArrayCount; ++i) {
+		free(scene->meshArrays[i]);
+	}
+
+	free(scene->meshArrays);
+	free(scene->objects);
+	free(scene->nodes);
+	free(scene->objectOrder);
+	free(scene->objectLeaf);
+	free(scene->dirtyObjects);
+	free(scene->visible);
+
+	*scene = (Scene){0};
+}
+
+static void updateWorldBounds(SceneObject* object) {
+	const mat4 model = mat4FromTransform(&object->transform);
+	object->worldBounds = transformAABB(&object->mesh->bounds, &model);
+	object->dirty = false;
+}
+
+static void reserveObjects(Scene* scene, const int count) {
+	if (count <= scene->objectCapacity) return;
+
+	int capacity = scene->objectCapacity ? scene->objectCapacity : 16;
+	while (capacity < count) capacity *= 2;
+
+	SceneObject* newObjects = realloc(scene->objects, capacity * sizeof(SceneObject));
+	int* newOrder = realloc(scene->objectOrder, capacity * sizeof(int));
+	int* newVisible = realloc(scene->visible, capacity * sizeof(int));
+	int* newLeaf = realloc(scene->objectLeaf, capacity * sizeof(int));
+	int* newDirty = realloc(scene->dirtyObjects, capacity * sizeof(int));
+
+	if (!newObjects || !newOrder || !newVisible || !newLeaf || !newDirty) {
+		puts("Error resizing scene objects");
+		raise(SIGTERM);
+	}
+
+	scene->objects = newObjects;
+	scene->objectOrder = newOrder;
+	scene->visible = newVisible;
+	scene->objectLeaf = newLeaf;
+	scene->dirtyObjects = newDirty;
+	scene->objectCapacity = capacity;
+}
+
+// Takes ownership of a mesh array from loadMeshFromOBJ, one object per mesh with an identity transform
+// Returns the index of the first new object
+int sceneAddMeshes(Scene* scene, Mesh* meshes, int meshCount) {
+	const int first = scene->objectCount;
+	if (!meshes || meshCount <= 0) return first;
+
+	Mesh** newArrays = realloc(scene->meshArrays, (scene->meshArrayCount + 1) * sizeof(Mesh*));
+	if (!newArrays) {
+		puts("Error resizing scene mesh list");
+		raise(SIGTERM);
+	}
+
+	scene->meshArrays = newArrays;
+	scene->meshArrays[scene->meshArrayCount++] = meshes;
+
+	reserveObjects(scene, scene->objectCount + meshCount);
+
+	for (int i=0; i<meshCount; ++i) {
+		SceneObject* object = &scene->objects[scene->objectCount++];
+
+		object->mesh = &meshes[i];
+		object->transform = (Transform){ {0,0,0}, {0,0,0}, {1,1,1} };
+		object->ownsMesh = true;
+		object->lod = 0;
+		updateWorldBounds(object);
+	}
+
+	// New objects change the tree shape
+	scene->needsRebuild = true;
+
+	return first;
+}
+
+// One object per transform all drawing the same mesh, each only costs a SceneObject.
+// The mesh stays owned by whoever added it (normally an object from sceneAddMeshes) and must outlive the scene
+// Returns the index of the first new object
+int sceneAddInstances(Scene* scene, Mesh* mesh, const Transform* transforms, const int count) {
+	const int first = scene->objectCount;
+	if (!mesh || !transforms || count <= 0) return first;
+
+	reserveObjects(scene, scene->objectCount + count);
+
+	for (int i=0; i<count; ++i) {
+		SceneObject* object = &scene->objects[scene->objectCount++];
+
+		object->mesh = mesh;
+		object->transform = transforms[i];
+		object->ownsMesh = false;
+		object->lod = 0;
+		updateWorldBounds(object);
+	}
+
+	scene->needsRebuild = true;
+
+	return first;
+}
+
+// Moving an object only needs its leaf and the nodes above it refitted, not a rebuild
+void sceneSetTransform(Scene* scene, int object, Transform transform) {
+	if (object < 0 || object >= scene->objectCount) return;
+
+	SceneObject* o = &scene->objects[object];
+	o->transform = transform;
+
+	if (!o->dirty) {
+		o->dirty = true;
+		scene->dirtyObjects[scene->dirtyCount++] = object;
+	}
+	scene->needsRefit = true;
+}
+
+// ========== BVH ==========
+
+static AABB mergeAABB(const AABB a, const AABB b) {
+	AABB r;
+	r.min = (v3){ fmin(a.min.x, b.min.x), fmin(a.min.y, b.min.y), fmin(a.min.z, b.min.z) };
+	r.max = (v3){ fmax(a.max.x, b.max.x), fmax(a.max.y, b.max.y), fmax(a.max.z, b.max.z) };
+	return r;
+}
+
+static double centroidAxis(const SceneObject* object, const int axis) {
+	const AABB* b = &object->worldBounds;
+
+	switch (axis) {
+		case 0:
+			return b->min.x + b->max.x;
+		case 1:
+			return b->min.y + b->max.y;
+		default:
+			return b->min.z + b->max.z;
+	}
+}
+
+static int pushNode(Scene* scene) {
+	if (scene->nodeCount == scene->nodeCapacity) {
+		const int capacity = scene->nodeCapacity ? scene->nodeCapacity * 2 : 32;
+
+		BVHNode* newNodes = realloc(scene->nodes, capacity * sizeof(BVHNode));
+		if (!newNodes) {
+			puts("Error resizing scene BVH");
+			raise(SIGTERM);
+		}
+
+		scene->nodes = newNodes;
+		scene->nodeCapacity = capacity;
+	}
+
+	return scene->nodeCount++;
+}
+
+// Partially orders objectOrder[begin, end) so the median along axis sits at mid (quickselect)
+static void selectMedian(Scene* scene, int begin, int end, const int mid, const int axis) {
+	int* order = scene->objectOrder;
+
+	while (end - begin > 1) {
+		const double pivot = centroidAxis(&scene->objects[order[(begin + end) / 2]], axis);
+
+		int i = begin, j = end - 1;
+		while (i <= j) {
+			while (centroidAxis(&scene->objects[order[i]], axis) < pivot) i++;
+			while (centroidAxis(&scene->objects[order[j]], axis) > pivot) j--;
+
+			if (i <= j) {
+				const int t = order[i]; order[i] = order[j]; order[j] = t;
+				i++;
+				j--;
+			}
+		}
+
+		if (mid <= j) end = j + 1;
+		else if (mid >= i) begin = i;
+		else return;
+	}
+}
+
+// Top down median split along the widest centroid axis, children are always after their parent
+static int buildNode(Scene* scene, const int begin, const int end, const int parent) {
+	const int index = pushNode(scene);
+
+	AABB bounds = scene->objects[scene->objectOrder[begin]].worldBounds;
+	AABB centroids = { {1e300, 1e300, 1e300}, {-1e300, -1e300, -1e300} };
+
+	for (int i=begin; i<end; ++i) {
+		const SceneObject* object = &scene->objects[scene->objectOrder[i]];
+		bounds = mergeAABB(bounds, object->worldBounds);
+
+		const v3 c = { centroidAxis(object, 0), centroidAxis(object, 1), centroidAxis(object, 2) };
+		centroids = mergeAABB(centroids, (AABB){ c, c });
+	}
+
+	if (end - begin <= SCENE_BVH_LEAF_SIZE) {
+		scene->nodes[index] = (BVHNode){ bounds, -1, -1, parent, begin, end - begin };
+
+		for (int i=begin; i<end; ++i) {
+			scene->objectLeaf[scene->objectOrder[i]] = index;
+		}
+		return index;
+	}
+
+	const v3 size = v3Sub(centroids.max, centroids.min);
+	int axis = 0;
+	if (size.y > size.x) axis = 1;
+	if (size.z > (axis == 0 ? size.x : size.y)) axis = 2;
+
+	const int mid = (begin + end) / 2;
+	selectMedian(scene, begin, end, mid, axis);
+
+	const int left = buildNode(scene, begin, mid, index);
+	const int right = buildNode(scene, mid, end, index);
+
+	// scene->nodes may have moved while building the children
+	scene->nodes[index] = (BVHNode){ bounds, left, right, parent, begin, end - begin };
+	return index;
+}
+
+static void rebuildBVH(Scene* scene) {
+	scene->nodeCount = 0;
+
+	for (int i=0; i<scene->objectCount; ++i) {
+		if (scene->objects[i].dirty) updateWorldBounds(&scene->objects[i]);
+		scene->objectOrder[i] = i;
+	}
+
+	if (scene->objectCount > 0) {
+		buildNode(scene, 0, scene->objectCount, -1);
+	}
+}
+
+static AABB leafBounds(const Scene* scene, const BVHNode* node) {
+	AABB bounds = scene->objects[scene->objectOrder[node->firstObject]].worldBounds;
+	for (int k=1; k<node->objectCount; ++k) {
+		bounds = mergeAABB(bounds, scene->objects[scene->objectOrder[node->firstObject + k]].worldBounds);
+	}
+	return bounds;
+}
+
+static bool sameAABB(const AABB a, const AABB b) {
+	return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z &&
+		a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+}
+
+// Children are stored after their parents, so one reverse pass refits bottom up
+static void refitAllNodes(Scene* scene) {
+	for (int i=scene->nodeCount-1; i>=0; --i) {
+		BVHNode* node = &scene->nodes[i];
+
+		if (node->left == -1) {
+			node->bounds = leafBounds(scene, node);
+		} else {
+			node->bounds = mergeAABB(scene->nodes[node->left].bounds, scene->nodes[node->right].bounds);
+		}
+	}
+}
+
+// Only the leaves of moved objects and the nodes above them. A walk stops at the first node whose bounds
+// didn't change, nothing above it can have either. When most objects moved one pass over every node is cheaper
+static void refitBVH(Scene* scene) {
+	for (int i=0; i<scene->dirtyCount; ++i) {
+		updateWorldBounds(&scene->objects[scene->dirtyObjects[i]]);
+	}
+
+	if (scene->dirtyCount * SCENE_BVH_REFIT_ALL_RATIO >= scene->nodeCount) {
+		refitAllNodes(scene);
+		return;
+	}
+
+	for (int i=0; i<scene->dirtyCount; ++i) {
+		int index = scene->objectLeaf[scene->dirtyObjects[i]];
+		AABB bounds = leafBounds(scene, &scene->nodes[index]);
+
+		while (index >= 0 && !sameAABB(bounds, scene->nodes[index].bounds)) {
+			BVHNode* node = &scene->nodes[index];
+			node->bounds = bounds;
+
+			index = node->parent;
+			if (index >= 0) {
+				const BVHNode* parent = &scene->nodes[index];
+				bounds = mergeAABB(scene->nodes[parent->left].bounds, scene->nodes[parent->right].bounds);
+			}
+		}
+	}
+}
+
+// Call once per frame before sceneQuery
+void sceneUpdate(Scene* scene) {
+	if (scene->needsRebuild) {
+		rebuildBVH(scene);
+	} else if (scene->needsRefit) {
+		refitBVH(scene);
+	}
+
+	scene->needsRebuild = false;
+	scene->needsRefit = false;
+	scene->dirtyCount = 0;
+}
+
+static void addSubtree(Scene* scene, const BVHNode* node) {
+	for (int k=0; k<node->objectCount; ++k) {
+		scene->visible[scene->visibleCount++] = scene->objectOrder[node->firstObject + k];
+	}
+}
+
+static void queryNode(Scene* scene, const int index, const Frustum* frustum) {
+	const BVHNode* node = &scene->nodes[index];
+	const int test = frustumTestAABB(frustum, &node->bounds);
+
+	if (test == FRUSTUM_OUTSIDE) return;
+
+	// Fully inside, everything below is visible without more plane tests
+	if (test == FRUSTUM_INSIDE) {
+		addSubtree(scene, node);
+		return;
+	}
+
+	// Leaf straddling the frustum, test its few objects individually
+	if (node->left == -1) {
+		for (int k=0; k<node->objectCount; ++k) {
+			const int object = scene->objectOrder[node->firstObject + k];
+
+			if (frustumTestAABB(frustum, &scene->objects[object].worldBounds) != FRUSTUM_OUTSIDE) {
+				scene->visible[scene->visibleCount++] = object;
+			}
+		}
+		return;
+	}
+
+	queryNode(scene, node->left, frustum);
+	queryNode(scene, node->right, frustum);
+}
+
+// Fills scene->visible with every object whose world bounds may touch the frustum
+void sceneQuery(Scene* scene, const Frustum* frustum) {
+	scene->visibleCount = 0;
+
+	if (scene->nodeCount > 0) {
+		queryNode(scene, 0, frustum);
+	}
+}
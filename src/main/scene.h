@@ -0,0 +1,76 @@
+// Scene of mesh instances with a bounding volume hierarchy for culling
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_SCENE_H
+#define CUBERENDER_SCENE_H
+
+#include "clip.h"
+#include "mesh.h"
+#include "vector.h"
+
+#define SCENE_BVH_LEAF_SIZE	4
+
+// Refits walk up from each moved object until one object moved per this many nodes, then every node is refitted
+#define SCENE_BVH_REFIT_ALL_RATIO	8
+
+typedef struct {
+	Mesh* mesh;
+	Transform transform;
+
+	// False for instances, which share another object's mesh and never free it
+	bool ownsMesh;
+
+	// World space bounds, refreshed from the mesh bounds when the transform changes
+	AABB worldBounds;
+	bool dirty;
+
+	// Level of detail drawn last frame (0 = full mesh), kept for hysteresis
+	int lod;
+} SceneObject;
+
+// Leaves have left == -1 and own objectCount entries of objectOrder from firstObject
+typedef struct {
+	AABB bounds;
+	int left, right;
+	int parent; // -1 for the root
+	int firstObject, objectCount;
+} BVHNode;
+
+typedef struct {
+	// Mesh arrays from loadMeshFromOBJ, owned by the scene
+	Mesh** meshArrays;
+	int meshArrayCount;
+
+	SceneObject* objects;
+	int objectCount, objectCapacity;
+
+	BVHNode* nodes;
+	int nodeCount, nodeCapacity;
+	int* objectOrder;
+
+	// Leaf node holding each object, so a moved object's refit starts at its leaf
+	int* objectLeaf;
+
+	// Objects moved since the last sceneUpdate, each listed once
+	int* dirtyObjects;
+	int dirtyCount;
+
+	bool needsRebuild;
+	bool needsRefit;
+
+	// Filled by sceneQuery
+	int* visible;
+	int visibleCount;
+} Scene;
+
+Scene newScene();
+void freeScene(Scene* scene);
+
+int sceneAddMeshes(Scene* scene, Mesh* meshes, int meshCount);
+int sceneAddInstances(Scene* scene, Mesh* mesh, const Transform* transforms, int count);
+void sceneSetTransform(Scene* scene, int object, Transform transform);
+
+void sceneUpdate(Scene* scene);
+void sceneQuery(Scene* scene, const Frustum* frustum);
+
+#endif //CUBERENDER_SCENE_H
@@ -0,0 +1,84 @@
+// Radix sort for per-frame draw ordering
+// Created by James Schaffer on 16/10/2026.
+
+#include "sort.h"
+
+#include <string.h>
+
+// Maps a float to a uint whose unsigned order matches the float order (negatives included)
+Uint32 floatSortKey(const float f) {
+	Uint32 u;
+	memcpy(&u, &f, sizeof(u));
+
+	const Uint32 mask = (u & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+	return u ^ mask;
+}
+
+// Takes room for maxCount pushes from the arena, the buffer is valid until the arena is reset
+void sortBegin(SortBuffer* buffer, Arena* arena, const size_t maxCount) {
+	buffer->keys = ARENA_ARRAY(arena, Uint32, maxCount);
+	buffer->values = ARENA_ARRAY(arena, Uint32, maxCount);
+	buffer->tmpKeys = ARENA_ARRAY(arena, Uint32, maxCount);
+	buffer->tmpValues = ARENA_ARRAY(arena, Uint32, maxCount);
+	buffer->capacity = maxCount;
+	buffer->count = 0;
+}
+
+void sortPush(SortBuffer* buffer, const Uint32 key, const Uint32 value) {
+	buffer->keys[buffer->count] = key;
+	buffer->values[buffer->count] = value;
+	buffer->count++;
+}
+
+// Stable LSD radix sort, ascending by key. O(n) with 4 passes of 8 bits,
+// passes where every key lands in the same bucket are skipped
+void radixSort(SortBuffer* buffer) {
+	const size_t n = buffer->count;
+	if (n < 2) return;
+
+	Uint32* keys = buffer->keys;
+	Uint32* values = buffer->values;
+	Uint32* tmpKeys = buffer->tmpKeys;
+	Uint32* tmpValues = buffer->tmpValues;
+
+	size_t histogram[4][SORT_RADIX_BUCKETS] = {0};
+
+	// All 4 histograms in one read
+	for (size_t i=0; i<n; ++i) {
+		const Uint32 k = keys[i];
+		histogram[0][k & 0xFF]++;
+		histogram[1][(k >> 8) & 0xFF]++;
+		histogram[2][(k >> 16) & 0xFF]++;
+		histogram[3][k >> 24]++;
+	}
+
+	for (int pass=0; pass<4; ++pass) {
+		const int shift = pass * SORT_RADIX_BITS;
+		size_t* h = histogram[pass];
+
+		if (h[(keys[0] >> shift) & 0xFF] == n) continue;
+
+		// Counts -> start offsets
+		size_t sum = 0;
+		for (int b=0; b<SORT_RADIX_BUCKETS; ++b) {
+			const size_t c = h[b];
+			h[b] = sum;
+			sum += c;
+		}
+
+		for (size_t i=0; i<n; ++i) {
+			const size_t dst = h[(keys[i] >> shift) & 0xFF]++;
+			tmpKeys[dst] = keys[i];
+			tmpValues[dst] = values[i];
+		}
+
+		Uint32* swap = keys; keys = tmpKeys; tmpKeys = swap;
+		swap = values; values = tmpValues; tmpValues = swap;
+	}
+
+	// Result may have ended up in the tmp arrays, swap the pointers rather than copying back
+	buffer->keys = keys;
+	buffer->values = values;
+	buffer->tmpKeys = tmpKeys;
+	buffer->tmpValues = tmpValues;
+}
@@ -0,0 +1,31 @@
+// Radix sort for per-frame draw ordering
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_SORT_H
+#define CUBERENDER_SORT_H
+
+#include <SDL3/SDL_stdinc.h>
+
+#include "arena.h"
+
+#define SORT_RADIX_BITS		8
+#define SORT_RADIX_BUCKETS	(1 << SORT_RADIX_BITS)
+
+// (key, value) pairs, the tmp arrays are the ping-pong buffers for each radix pass
+typedef struct {
+	Uint32* keys;
+	Uint32* values;
+	Uint32* tmpKeys;
+	Uint32* tmpValues;
+
+	size_t count, capacity;
+} SortBuffer;
+
+
+Uint32 floatSortKey(float f);
+
+void sortBegin(SortBuffer* buffer, Arena* arena, size_t maxCount);
+void sortPush(SortBuffer* buffer, Uint32 key, Uint32 value);
+void radixSort(SortBuffer* buffer);
+
+#endif //CUBERENDER_SORT_H
@@ -0,0 +1,173 @@
+// Mipmapped textures stored in cache sized tiles
+// Created by James Schaffer on 16/10/2026.
+
+#include "texture.h"
+#include "capture.h"
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* allocOrDie(const size_t count, const size_t elemSize) {
+	void* ptr = malloc((count ? count : 1) * elemSize);
+	if (!ptr) {
+		puts("Error allocating texture memory");
+		raise(SIGTERM);
+	}
+	return ptr;
+}
+
+// ========== IMAGE ==========
+
+// Whole image as ARGB8888 rows with no padding
+static Uint32* loadImage(const char* path, int* width, int* height) {
+	const char* ext = strrchr(path, '.');
+	const bool ppm = ext && (strcmp(ext, ".ppm") == 0 || strcmp(ext, ".PPM") == 0);
+
+	SDL_Surface* surface = ppm ? readPPM(path) : SDL_LoadBMP(path);
+	if (!surface) {
+		printf("Error loading texture '%s' (only .bmp and .ppm are supported) : %s\n", path, ppm ? "bad ppm" : SDL_GetError());
+		return NULL;
+	}
+
+	SDL_Surface* argb = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+	SDL_DestroySurface(surface);
+
+	if (!argb) {
+		printf("Error converting texture '%s' : %s\n", path, SDL_GetError());
+		return NULL;
+	}
+
+	Uint32* pixels = allocOrDie((size_t)argb->w * argb->h, sizeof(Uint32));
+	for (int y=0; y<argb->h; ++y) {
+		memcpy(pixels + (size_t)y * argb->w, (const Uint8*)argb->pixels + (size_t)y * argb->pitch, (size_t)argb->w * sizeof(Uint32));
+	}
+
+	*width = argb->w;
+	*height = argb->h;
+	SDL_DestroySurface(argb);
+
+	return pixels;
+}
+
+// ========== MIP CHAIN ==========
+
+// Half size (rounded up) box filter, odd edges reuse their last row / column
+static Uint32* downsample(const Uint32* src, const int width, const int height, int* outWidth, int* outHeight) {
+	const int w = width > 1 ? (width + 1) / 2 : 1;
+	const int h = height > 1 ? (height + 1) / 2 : 1;
+
+	Uint32* dst = allocOrDie((size_t)w * h, sizeof(Uint32));
+
+	for (int y=0; y<h; ++y) {
+		const int y0 = SDL_min(y * 2, height - 1);
+		const int y1 = SDL_min(y * 2 + 1, height - 1);
+
+		for (int x=0; x<w; ++x) {
+			const int x0 = SDL_min(x * 2, width - 1);
+			const int x1 = SDL_min(x * 2 + 1, width - 1);
+
+			const Uint32 p[4] = {
+				src[(size_t)y0 * width + x0], src[(size_t)y0 * width + x1],
+				src[(size_t)y1 * width + x0], src[(size_t)y1 * width + x1]
+			};
+
+			Uint32 out = 0;
+			for (int shift=0; shift<32; shift+=8) {
+				Uint32 sum = 2;
+				for (int i=0; i<4; ++i) sum += (p[i] >> shift) & 0xFF;
+				out |= (sum / 4) << shift;
+			}
+
+			dst[(size_t)y * w + x] = out;
+		}
+	}
+
+	*outWidth = w;
+	*outHeight = h;
+	return dst;
+}
+
+// Tiled copy for the rasterizer plus the renderer's own copy of the level
+static void buildLevel(TextureLevel* level, SDL_Renderer* renderer, const Uint32* pixels, const int width, const int height) {
+	level->width = width;
+	level->height = height;
+	level->tilesX = (width + TEXTURE_TILE_MASK) >> TEXTURE_TILE_SHIFT;
+	level->tilesY = (height + TEXTURE_TILE_MASK) >> TEXTURE_TILE_SHIFT;
+
+	// Partial tiles at the right and bottom edges are padded, the padding is never sampled
+	const size_t tileTexels = (size_t)1 << (2 * TEXTURE_TILE_SHIFT);
+	level->texels = SDL_aligned_alloc(tileTexels * sizeof(Uint32), (size_t)level->tilesX * level->tilesY * tileTexels * sizeof(Uint32));
+	if (!level->texels) {
+		puts("Error allocating texture memory");
+		raise(SIGTERM);
+	}
+
+	for (int y=0; y<height; ++y) {
+		for (int x=0; x<width; ++x) {
+			level->texels[TEXTURE_TEXEL_INDEX(level, x, y)] = pixels[(size_t)y * width + x];
+		}
+	}
+
+	level->gpu = NULL;
+	if (!renderer) return;
+
+	level->gpu = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+	if (!level->gpu) {
+		SDL_Log("Failed to create texture level %ix%i: %s", width, height, SDL_GetError());
+		return;
+	}
+
+	SDL_UpdateTexture(level->gpu, NULL, pixels, width * (int)sizeof(Uint32));
+}
+
+Texture* loadTexture(SDL_Renderer* renderer, const char* path) {
+	int width, height;
+	Uint32* pixels = loadImage(path, &width, &height);
+	if (!pixels) return NULL;
+
+	Texture* texture = calloc(1, sizeof(Texture));
+	if (!texture) {
+		puts("Error allocating texture memory");
+		raise(SIGTERM);
+	}
+
+	for (;;) {
+		buildLevel(&texture->levels[texture->levelCount++], renderer, pixels, width, height);
+
+		if ((width == 1 && height == 1) || texture->levelCount == TEXTURE_MAX_LEVELS) break;
+
+		Uint32* next = downsample(pixels, width, height, &width, &height);
+		free(pixels);
+		pixels = next;
+	}
+
+	free(pixels);
+	return texture;
+}
+
+void freeTexture(Texture* texture) {
+	if (!texture) return;
+
+	for (int i=0; i<texture->levelCount; ++i) {
+		SDL_aligned_free(texture->levels[i].texels);
+		if (texture->levels[i].gpu) SDL_DestroyTexture(texture->levels[i].gpu);
+	}
+
+	free(texture);
+}
+
+// ========== LEVEL SELECTION ==========
+
+// Each level has a quarter of the texels, so the level is half the log2 of texels per pixel (rounded)
+int textureLevelForArea(const Texture* texture, const float uvArea, const float screenArea) {
+	const TextureLevel* base = &texture->levels[0];
+	const float texels = uvArea * (float)base->width * (float)base->height;
+
+	if (screenArea <= 0.0f || texels <= screenArea) return 0;
+
+	const int level = (int)(0.5f * log2f(texels / screenArea) + 0.5f);
+	return SDL_min(level, texture->levelCount - 1);
+}
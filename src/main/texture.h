@@ -0,0 +1,45 @@
+// Mipmapped textures stored in cache sized tiles
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_TEXTURE_H
+#define CUBERENDER_TEXTURE_H
+
+#include <SDL3/SDL_render.h>
+
+// Texels are stored in 4x4 tiles (64 bytes, one cache line) so the texels around a sample are in one line
+// instead of spread across 4 rows of the image
+#define TEXTURE_TILE_SHIFT	2
+#define TEXTURE_TILE_SIZE	(1 << TEXTURE_TILE_SHIFT)
+#define TEXTURE_TILE_MASK	(TEXTURE_TILE_SIZE - 1)
+
+// Enough for a 32768 texel wide image down to 1x1
+#define TEXTURE_MAX_LEVELS	16
+
+// Texel (x, y) of a level, x and y must already be wrapped into the level
+#define TEXTURE_TEXEL_INDEX(level, x, y) \
+	(((size_t)(((y) >> TEXTURE_TILE_SHIFT) * (level)->tilesX + ((x) >> TEXTURE_TILE_SHIFT)) << (2 * TEXTURE_TILE_SHIFT)) | \
+	(((y) & TEXTURE_TILE_MASK) << TEXTURE_TILE_SHIFT) | ((x) & TEXTURE_TILE_MASK))
+
+typedef struct {
+	int width, height;
+	int tilesX, tilesY;
+
+	Uint32* texels;		// ARGB8888 in tiles for the software rasterizer
+	SDL_Texture* gpu;	// The same level for SDL_RenderGeometry, NULL without a renderer
+} TextureLevel;
+
+// levels[0] is the image, every level after is half the size of the last (box filtered) down to 1x1
+typedef struct {
+	TextureLevel levels[TEXTURE_MAX_LEVELS];
+	int levelCount;
+} Texture;
+
+// .bmp (through SDL) and binary .ppm images. Returns NULL (after printing why) if it can't be loaded
+Texture* loadTexture(SDL_Renderer* renderer, const char* path);
+void freeTexture(Texture* texture);
+
+// Level whose texel size best matches the pixels covering it : uvArea is the triangle's area in texture
+// coordinates (0-1), screenArea its area in pixels
+int textureLevelForArea(const Texture* texture, float uvArea, float screenArea);
+
+#endif //CUBERENDER_TEXTURE_H
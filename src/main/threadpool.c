@@ -0,0 +1,144 @@
+// Worker thread pool for parallel per-frame jobs
+// Created by James Schaffer on 16/10/2026.
+
+#include "threadpool.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Drain own range first, then steal from the others
+static void runTasks(ThreadPool* pool, const int self) {
+	for (int k=0; k<pool->workerCount; ++k) {
+		ThreadPoolRange* range = &pool->ranges[(self + k) % pool->workerCount];
+
+		int task;
+		while ((task = SDL_AddAtomicInt(&range->next, 1)) < range->end) {
+			pool->task(task, self, pool->userdata);
+		}
+	}
+}
+
+static int workerMain(void* data) {
+	const ThreadPoolWorker* worker = data;
+	ThreadPool* pool = worker->pool;
+
+	int seen = 0;
+
+	SDL_LockMutex(pool->lock);
+	for (;;) {
+		while (!pool->quit && pool->generation == seen) {
+			SDL_WaitCondition(pool->wake, pool->lock);
+		}
+
+		if (pool->quit) break;
+
+		seen = pool->generation;
+		SDL_UnlockMutex(pool->lock);
+
+		runTasks(pool, worker->index);
+
+		SDL_LockMutex(pool->lock);
+		if (--pool->pending == 0) {
+			SDL_SignalCondition(pool->done);
+		}
+	}
+	SDL_UnlockMutex(pool->lock);
+
+	return 0;
+}
+
+// workerCount includes the calling thread, so workerCount-1 threads are started
+ThreadPool* createThreadPool(int workerCount) {
+	if (workerCount < 1) workerCount = 1;
+
+	ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+	if (!pool) {
+		puts("Error allocating thread pool");
+		raise(SIGTERM);
+	}
+
+	pool->workerCount = workerCount;
+	pool->threads = calloc(workerCount, sizeof(SDL_Thread*));
+	pool->workers = calloc(workerCount, sizeof(ThreadPoolWorker));
+	pool->ranges = calloc(workerCount, sizeof(ThreadPoolRange));
+
+	pool->lock = SDL_CreateMutex();
+	pool->wake = SDL_CreateCondition();
+	pool->done = SDL_CreateCondition();
+
+	if (!pool->threads || !pool->workers || !pool->ranges || !pool->lock || !pool->wake || !pool->done) {
+		puts("Error allocating thread pool");
+		raise(SIGTERM);
+	}
+
+	for (int i=0; i<workerCount; ++i) {
+		pool->workers[i] = (ThreadPoolWorker){ pool, i };
+	}
+
+	for (int i=1; i<workerCount; ++i) {
+		pool->threads[i] = SDL_CreateThread(workerMain, "RenderWorker", &pool->workers[i]);
+
+		if (!pool->threads[i]) {
+			SDL_Log("Failed to create worker thread: %s", SDL_GetError());
+			pool->workerCount = i;
+			break;
+		}
+	}
+
+	return pool;
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+	if (!pool) return;
+
+	SDL_LockMutex(pool->lock);
+	pool->quit = true;
+	SDL_BroadcastCondition(pool->wake);
+	SDL_UnlockMutex(pool->lock);
+
+	for (int i=1; i<pool->workerCount; ++i) {
+		SDL_WaitThread(pool->threads[i], NULL);
+	}
+
+	SDL_DestroyCondition(pool->done);
+	SDL_DestroyCondition(pool->wake);
+	SDL_DestroyMutex(pool->lock);
+
+	free(pool->threads);
+	free(pool->workers);
+	free(pool->ranges);
+	free(pool);
+}
+
+// Runs task(0..taskCount-1) across every worker and blocks until all of them are done
+void threadPoolRun(ThreadPool* pool, const int taskCount, const ThreadPoolTask task, void* userdata) {
+	if (taskCount <= 0) return;
+
+	// Contiguous slices so neighbouring tasks (e.g. tiles) stay on one core unless stolen
+	for (int i=0; i<pool->workerCount; ++i) {
+		SDL_SetAtomicInt(&pool->ranges[i].next, (int)((long long)taskCount * i / pool->workerCount));
+		pool->ranges[i].end = (int)((long long)taskCount * (i+1) / pool->workerCount);
+	}
+
+	pool->task = task;
+	pool->userdata = userdata;
+
+	if (pool->workerCount > 1) {
+		SDL_LockMutex(pool->lock);
+		pool->pending = pool->workerCount - 1;
+		pool->generation++;
+		SDL_BroadcastCondition(pool->wake);
+		SDL_UnlockMutex(pool->lock);
+	}
+
+	runTasks(pool, 0);
+
+	if (pool->workerCount > 1) {
+		SDL_LockMutex(pool->lock);
+		while (pool->pending > 0) {
+			SDL_WaitCondition(pool->done, pool->lock);
+		}
+		SDL_UnlockMutex(pool->lock);
+	}
+}
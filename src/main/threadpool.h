@@ -0,0 +1,55 @@
+// Worker thread pool for parallel per-frame jobs
+// Created by James Schaffer on 16/10/2026.
+
+#ifndef CUBERENDER_THREADPOOL_H
+#define CUBERENDER_THREADPOOL_H
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+
+// Padded so each worker's cursor sits on its own cache line
+#define THREADPOOL_CACHE_LINE 64
+
+// Called once per task index, worker is 0..workerCount-1 (0 is the calling thread)
+typedef void (*ThreadPoolTask)(int task, int worker, void* userdata);
+
+// Tasks [next, end) still owned by a worker, other workers steal from it once theirs run out
+typedef struct {
+	SDL_AtomicInt next;
+	int end;
+	char pad[THREADPOOL_CACHE_LINE - sizeof(SDL_AtomicInt) - sizeof(int)];
+} ThreadPoolRange;
+
+typedef struct ThreadPool ThreadPool;
+
+typedef struct {
+	ThreadPool* pool;
+	int index;
+} ThreadPoolWorker;
+
+struct ThreadPool {
+	int workerCount;
+
+	SDL_Thread** threads;
+	ThreadPoolWorker* workers;
+	ThreadPoolRange* ranges;
+
+	SDL_Mutex* lock;
+	SDL_Condition* wake;
+	SDL_Condition* done;
+
+	int generation;
+	int pending;
+	bool quit;
+
+	ThreadPoolTask task;
+	void* userdata;
+};
+
+ThreadPool* createThreadPool(int workerCount);
+void destroyThreadPool(ThreadPool* pool);
+
+void threadPoolRun(ThreadPool* pool, int taskCount, ThreadPoolTask task, void* userdata);
+
+#endif //CUBERENDER_THREADPOOL_H
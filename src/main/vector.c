@@ -96,4 +96,160 @@ v3 transformV3(const v3* v, const Transform* t) {
 	ret.z += t->position.z;
 
 	return ret;
-}
\ No newline at end of file
+}
+// ========== MATRIX FUNCTIONS ==========
+
+mat4 mat4Identity() {
+	mat4 r = {0};
+	r.m[0][0] = 1;
+	r.m[1][1] = 1;
+	r.m[2][2] = 1;
+	r.m[3][3] = 1;
+	return r;
+}
+
+mat4 mat4Mul(const mat4* a, const mat4* b) {
+	mat4 r;
+	for (int i=0; i<4; ++i) {
+		for (int j=0; j<4; ++j) {
+			r.m[i][j] = a->m[i][0]*b->m[0][j] + a->m[i][1]*b->m[1][j] + a->m[i][2]*b->m[2][j] + a->m[i][3]*b->m[3][j];
+		}
+	}
+	return r;
+}
+
+mat4 mat4Transpose(const mat4* m) {
+	mat4 r;
+	for (int i=0; i<4; ++i) {
+		for (int j=0; j<4; ++j) {
+			r.m[i][j] = m->m[j][i];
+		}
+	}
+	return r;
+}
+
+// General inverse by cofactor expansion, returns 0 if the matrix is singular
+int mat4Inverse(const mat4* m, mat4* out) {
+	const double* a = &m->m[0][0];
+	double inv[16];
+
+	inv[0] = a[5]*a[10]*a[15] - a[5]*a[11]*a[14] - a[9]*a[6]*a[15] + a[9]*a[7]*a[14] + a[13]*a[6]*a[11] - a[13]*a[7]*a[10];
+	inv[4] = -a[4]*a[10]*a[15] + a[4]*a[11]*a[14] + a[8]*a[6]*a[15] - a[8]*a[7]*a[14] - a[12]*a[6]*a[11] + a[12]*a[7]*a[10];
+	inv[8] = a[4]*a[9]*a[15] - a[4]*a[11]*a[13] - a[8]*a[5]*a[15] + a[8]*a[7]*a[13] + a[12]*a[5]*a[11] - a[12]*a[7]*a[9];
+	inv[12] = -a[4]*a[9]*a[14] + a[4]*a[10]*a[13] + a[8]*a[5]*a[14] - a[8]*a[6]*a[13] - a[12]*a[5]*a[10] + a[12]*a[6]*a[9];
+	inv[1] = -a[1]*a[10]*a[15] + a[1]*a[11]*a[14] + a[9]*a[2]*a[15] - a[9]*a[3]*a[14] - a[13]*a[2]*a[11] + a[13]*a[3]*a[10];
+	inv[5] = a[0]*a[10]*a[15] - a[0]*a[11]*a[14] - a[8]*a[2]*a[15] + a[8]*a[3]*a[14] + a[12]*a[2]*a[11] - a[12]*a[3]*a[10];
+	inv[9] = -a[0]*a[9]*a[15] + a[0]*a[11]*a[13] + a[8]*a[1]*a[15] - a[8]*a[3]*a[13] - a[12]*a[1]*a[11] + a[12]*a[3]*a[9];
+	inv[13] = a[0]*a[9]*a[14] - a[0]*a[10]*a[13] - a[8]*a[1]*a[14] + a[8]*a[2]*a[13] + a[12]*a[1]*a[10] - a[12]*a[2]*a[9];
+	inv[2] = a[1]*a[6]*a[15] - a[1]*a[7]*a[14] - a[5]*a[2]*a[15] + a[5]*a[3]*a[14] + a[13]*a[2]*a[7] - a[13]*a[3]*a[6];
+	inv[6] = -a[0]*a[6]*a[15] + a[0]*a[7]*a[14] + a[4]*a[2]*a[15] - a[4]*a[3]*a[14] - a[12]*a[2]*a[7] + a[12]*a[3]*a[6];
+	inv[10] = a[0]*a[5]*a[15] - a[0]*a[7]*a[13] - a[4]*a[1]*a[15] + a[4]*a[3]*a[13] + a[12]*a[1]*a[7] - a[12]*a[3]*a[5];
+	inv[14] = -a[0]*a[5]*a[14] + a[0]*a[6]*a[13] + a[4]*a[1]*a[14] - a[4]*a[2]*a[13] - a[12]*a[1]*a[6] + a[12]*a[2]*a[5];
+	inv[3] = -a[1]*a[6]*a[11] + a[1]*a[7]*a[10] + a[5]*a[2]*a[11] - a[5]*a[3]*a[10] - a[9]*a[2]*a[7] + a[9]*a[3]*a[6];
+	inv[7] = a[0]*a[6]*a[11] - a[0]*a[7]*a[10] - a[4]*a[2]*a[11] + a[4]*a[3]*a[10] + a[8]*a[2]*a[7] - a[8]*a[3]*a[6];
+	inv[11] = -a[0]*a[5]*a[11] + a[0]*a[7]*a[9] + a[4]*a[1]*a[11] - a[4]*a[3]*a[9] - a[8]*a[1]*a[7] + a[8]*a[3]*a[5];
+	inv[15] = a[0]*a[5]*a[10] - a[0]*a[6]*a[9] - a[4]*a[1]*a[10] + a[4]*a[2]*a[9] + a[8]*a[1]*a[6] - a[8]*a[2]*a[5];
+
+	const double det = a[0]*inv[0] + a[1]*inv[4] + a[2]*inv[8] + a[3]*inv[12];
+	if (fabs(det) < 1e-12) return 0;
+
+	const double invDet = 1.0 / det;
+	double* o = &out->m[0][0];
+	for (int i=0; i<16; ++i) {
+		o[i] = inv[i] * invDet;
+	}
+
+	return 1;
+}
+
+mat4 mat4Translation(const v3 t) {
+	mat4 r = mat4Identity();
+	r.m[0][3] = t.x;
+	r.m[1][3] = t.y;
+	r.m[2][3] = t.z;
+	return r;
+}
+
+mat4 mat4Scale(const v3 s) {
+	mat4 r = mat4Identity();
+	r.m[0][0] = s.x;
+	r.m[1][1] = s.y;
+	r.m[2][2] = s.z;
+	return r;
+}
+
+// Same rotation order as transformV3 (Rz * Ry * Rx)
+mat4 mat4Rotation(const v3 rot) {
+	const double cx = cos(rot.x);
+	const double sx = sin(rot.x);
+	const double cy = cos(rot.y);
+	const double sy = sin(rot.y);
+	const double cz = cos(rot.z);
+	const double sz = sin(rot.z);
+
+	mat4 r = mat4Identity();
+	r.m[0][0] = cy*cz;
+	r.m[0][1] = (sx*sy*cz)-(cx*sz);
+	r.m[0][2] = (cx*sy*cz)+(sx*sz);
+	r.m[1][0] = cy*sz;
+	r.m[1][1] = (sx*sy*sz)+(cx*cz);
+	r.m[1][2] = (cx*sy*sz)-(sx*cz);
+	r.m[2][0] = -sy;
+	r.m[2][1] = sx*cy;
+	r.m[2][2] = cx*cy;
+	return r;
+}
+
+// Scale, then rotate, then translate (matches transformV3)
+mat4 mat4FromTransform(const Transform* t) {
+	const mat4 s = mat4Scale(t->scale);
+	const mat4 r = mat4Rotation(t->rotation);
+	const mat4 tr = mat4Translation(t->position);
+
+	const mat4 rs = mat4Mul(&r, &s);
+	return mat4Mul(&tr, &rs);
+}
+
+// View matrix, view space is x right, y up and z forward (depth)
+mat4 mat4LookAt(const v3 eye, const v3 target, const v3 up) {
+	const v3 f = normalize(v3Sub(target, eye));
+	const v3 r = normalize(crossProduct(up, f));
+	const v3 u = crossProduct(f, r);
+
+	mat4 m = mat4Identity();
+	m.m[0][0] = r.x; m.m[0][1] = r.y; m.m[0][2] = r.z; m.m[0][3] = -dotProduct(r, eye);
+	m.m[1][0] = u.x; m.m[1][1] = u.y; m.m[1][2] = u.z; m.m[1][3] = -dotProduct(u, eye);
+	m.m[2][0] = f.x; m.m[2][1] = f.y; m.m[2][2] = f.z; m.m[2][3] = -dotProduct(f, eye);
+	return m;
+}
+
+// Perspective from a horizontal fov, clip w is view depth and z/w maps near..far to 0..1
+mat4 mat4Perspective(const double fovX, const double aspect, const double zNear, const double zFar) {
+	const double sx = 1.0 / tan(fovX / 2);
+
+	mat4 m = {0};
+	m.m[0][0] = sx;
+	m.m[1][1] = sx * aspect;
+	m.m[2][2] = zFar / (zFar - zNear);
+	m.m[2][3] = -(zNear * zFar) / (zFar - zNear);
+	m.m[3][2] = 1;
+	return m;
+}
+
+v4 mat4MulPoint(const mat4* m, const v3 p) {
+	v4 r;
+	r.x = m->m[0][0]*p.x + m->m[0][1]*p.y + m->m[0][2]*p.z + m->m[0][3];
+	r.y = m->m[1][0]*p.x + m->m[1][1]*p.y + m->m[1][2]*p.z + m->m[1][3];
+	r.z = m->m[2][0]*p.x + m->m[2][1]*p.y + m->m[2][2]*p.z + m->m[2][3];
+	r.w = m->m[3][0]*p.x + m->m[3][1]*p.y + m->m[3][2]*p.z + m->m[3][3];
+	return r;
+}
+
+// Ignores translation
+v3 mat4MulDir(const mat4* m, const v3 d) {
+	v3 r;
+	r.x = m->m[0][0]*d.x + m->m[0][1]*d.y + m->m[0][2]*d.z;
+	r.y = m->m[1][0]*d.x + m->m[1][1]*d.y + m->m[1][2]*d.z;
+	r.z = m->m[2][0]*d.x + m->m[2][1]*d.y + m->m[2][2]*d.z;
+	return r;
+}
@@ -18,6 +18,13 @@ typedef struct v3i {
 	int z;
 } v3i;
 
+typedef struct v4 {
+	double x;
+	double y;
+	double z;
+	double w;
+} v4;
+
 typedef struct v2 {
 	double x;
 	double y;
@@ -35,6 +42,25 @@ typedef struct  {
 	v3 scale;
 } Transform;
 
+// ========== BOUNDS STRUCTS ==========
+
+typedef struct {
+	v3 min;
+	v3 max;
+} AABB;
+
+typedef struct {
+	v3 center;
+	double radius;
+} Sphere;
+
+// ========== MATRIX STRUCT ==========
+
+// Row major, vectors are treated as columns (p' = M * p)
+typedef struct mat4 {
+	double m[4][4];
+} mat4;
+
 // ========== VECTOR FUNCTIONS ==========
 
 int clampi(int d, int min, int max);
@@ -55,4 +81,22 @@ v2 normalizev2(v2 v);
 
 v3 transformV3(const v3* v, const Transform* t);
 
+// ========== MATRIX FUNCTIONS ==========
+
+mat4 mat4Identity();
+mat4 mat4Mul(const mat4* a, const mat4* b);
+mat4 mat4Transpose(const mat4* m);
+int mat4Inverse(const mat4* m, mat4* out);
+
+mat4 mat4Translation(v3 t);
+mat4 mat4Scale(v3 s);
+mat4 mat4Rotation(v3 r);
+mat4 mat4FromTransform(const Transform* t);
+
+mat4 mat4LookAt(v3 eye, v3 target, v3 up);
+mat4 mat4Perspective(double fovX, double aspect, double zNear, double zFar);
+
+v4 mat4MulPoint(const mat4* m, v3 p);
+v3 mat4MulDir(const mat4* m, v3 d);
+
 #endif //CUBERENDER_VECTORS_H
\ No newline at end of file